@@ -13,6 +13,8 @@
 #include <deque>
 #include <algorithm>
 
+#include "src/common/random.hpp"
+
 struct ProgramParams {
     int X;  // Timeout seconds for control entities
     int Y;  // Base unloading time in seconds
@@ -110,11 +112,8 @@ public:
             cv.wait(lock);
         }
 
-        // Random damage check
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-        if (dis(gen) < params.P) {
+        // Random damage check, from this thread's own generator
+        if (ecuafast::random::local().uniform() < params.P) {
             std::cout << "Ship " << ship.id << " damaged during approach\n";
             dockingQueue.remove_if([&ship](const Ship& s) { 
                 return s.id == ship.id; 
@@ -236,12 +235,9 @@ public:
     SUPERCIA() : ControlEntity("SUPERCIA") {}
 
     Response evaluate(const Ship& ship, Statistics& stats) override {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0.0, 1.0);
-        
         double threshold = (ship.type == ShipType::CONVENTIONAL) ? 0.3 : 0.5;
-        return (dis(gen) < threshold) ? Response::CHECK : Response::PASS;
+        return (ecuafast::random::local().uniform() < threshold)
+            ? Response::CHECK : Response::PASS;
     }
 };
 
@@ -251,8 +247,7 @@ void shipProcess(int id, Port& port, std::vector<std::shared_ptr<ControlEntity>>
     ship.id = id;
     
     // Initialize ship properties
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    ecuafast::Random& gen = ecuafast::random::local();
     std::uniform_real_distribution<> weightDis(10000, 50000);
     std::uniform_int_distribution<> typeDis(0, 1);
     std::uniform_int_distribution<> destDis(0, 1);
@@ -0,0 +1,65 @@
+#include "arrival_process.hpp"
+
+#include <cmath>
+
+#include "utils.hpp"
+
+namespace ecuafast {
+
+namespace {
+// Busy and quiet MMPP rates are the target times 1 +/- this
+constexpr double BURST_SPREAD = 0.8;
+}  // namespace
+
+ArrivalGenerator::ArrivalGenerator(ArrivalPattern pattern, double rate,
+                                   int count, double burstSeconds,
+                                   uint64_t seed)
+    : pattern(pattern),
+      rate(rate > 0 ? rate : 1.0),
+      count(count),
+      burstSeconds(burstSeconds > 0 ? burstSeconds : 1.0),
+      random(seed) {
+  stateEnds = exponential(1.0 / this->burstSeconds);
+}
+
+bool ArrivalGenerator::next(Arrival& arrival) {
+  if (issued >= count) {
+    return false;
+  }
+
+  // The first ship arrives at time zero
+  if (issued > 0) {
+    switch (pattern) {
+      case ArrivalPattern::CONSTANT:
+        time = issued / rate;
+        break;
+      case ArrivalPattern::POISSON:
+        time += exponential(rate);
+        break;
+      case ArrivalPattern::MMPP:
+        while (true) {
+          double spread = busy ? BURST_SPREAD : -BURST_SPREAD;
+          double gap = exponential(rate * (1 + spread));
+          if (time + gap <= stateEnds) {
+            time += gap;
+            break;
+          }
+          // Gaps are memoryless, so drawing afresh in the new state is exact
+          time = stateEnds;
+          busy = !busy;
+          stateEnds = time + exponential(1.0 / burstSeconds);
+        }
+        break;
+    }
+  }
+
+  arrival.time = time;
+  arrival.ship = utils::generateRandomShip(issued++);
+  return true;
+}
+
+double ArrivalGenerator::exponential(double rate) {
+  return -std::log1p(-random.uniform()) / rate;
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+#include "arrival_trace.hpp"
+#include "random.hpp"
+
+namespace ecuafast {
+// How arrivals are spaced
+enum class ArrivalPattern {
+  CONSTANT,  // evenly, one every 1/rate seconds
+  POISSON,   // independent exponential gaps
+  MMPP       // Poisson switching between a busy and a quiet rate
+};
+
+// Open-loop arrivals of generated ships at a target rate, read like a
+// trace. Times depend only on the seed, never on how fast earlier ships
+// were served. The MMPP alternates between 1.8x and 0.2x the target rate,
+// with exponentially distributed stays averaging `burstSeconds` in each,
+// so it keeps the same long-run rate but comes in waves.
+class ArrivalGenerator {
+ public:
+  ArrivalGenerator(ArrivalPattern pattern, double rate, int count,
+                   double burstSeconds, uint64_t seed);
+
+  // False after `count` ships
+  bool next(Arrival& arrival);
+
+ private:
+  ArrivalPattern pattern;
+  double rate;
+  int count;
+  double burstSeconds;
+  Random random;
+  double time = 0.0;
+  int issued = 0;
+  bool busy = true;
+  double stateEnds;
+
+  double exponential(double rate);
+};
+}  // namespace ecuafast
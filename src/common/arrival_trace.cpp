@@ -0,0 +1,165 @@
+#include "arrival_trace.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace ecuafast {
+
+namespace {
+constexpr char BINARY_MAGIC[8] = {'E', 'F', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr size_t BINARY_HEADER_SIZE = 16;
+constexpr size_t BINARY_RECORD_SIZE = 32;
+constexpr size_t BINARY_DESTINATION_SIZE = 14;
+// Longest CSV destination: even escaped as \u00XX throughout, the ship
+// still fits in one ship_json::MAX_SIZE message
+constexpr size_t CSV_DESTINATION_SIZE = 64;
+
+bool parseDouble(std::string_view field, double& value) {
+  auto [end, error] =
+      std::from_chars(field.data(), field.data() + field.size(), value);
+  return error == std::errc() && end == field.data() + field.size();
+}
+
+bool parseType(std::string_view field, ShipType& type) {
+  if (field == "conventional" || field == "CONVENTIONAL" || field == "0") {
+    type = ShipType::CONVENTIONAL;
+  } else if (field == "panamax" || field == "PANAMAX" || field == "1") {
+    type = ShipType::PANAMAX;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Splits off the text up to the next comma
+std::string_view nextField(std::string_view& rest) {
+  size_t comma = rest.find(',');
+  std::string_view field = rest.substr(0, comma);
+  rest = comma == std::string_view::npos ? std::string_view()
+                                         : rest.substr(comma + 1);
+  return field;
+}
+}  // namespace
+
+ArrivalTrace::ArrivalTrace(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open trace " + path);
+  }
+
+  struct stat info {};
+  if (fstat(fd, &info) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Failed to open trace " + path);
+  }
+  size = info.st_size;
+
+  if (size > 0) {
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Failed to map trace " + path);
+    }
+    // Read ahead aggressively and let pages behind the cursor go
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(mapped);
+  }
+  ::close(fd);
+
+  if (size >= BINARY_HEADER_SIZE &&
+      std::memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+    binary = true;
+    std::memcpy(&remaining, data + sizeof(BINARY_MAGIC), sizeof(remaining));
+    offset = BINARY_HEADER_SIZE;
+  }
+}
+
+ArrivalTrace::~ArrivalTrace() {
+  if (data) {
+    munmap(const_cast<char*>(data), size);
+  }
+}
+
+bool ArrivalTrace::next(Arrival& arrival) {
+  return binary ? nextBinary(arrival) : nextCsv(arrival);
+}
+
+bool ArrivalTrace::nextBinary(Arrival& arrival) {
+  if (remaining == 0) {
+    return false;
+  }
+  if (size - offset < BINARY_RECORD_SIZE) {
+    throw std::runtime_error("Trace ends before its last record");
+  }
+
+  const char* record = data + offset;
+  uint8_t type;
+  uint8_t length;
+  std::memcpy(&arrival.time, record, sizeof(double));
+  std::memcpy(&arrival.ship.avgWeight, record + 8, sizeof(double));
+  std::memcpy(&type, record + 16, 1);
+  std::memcpy(&length, record + 17, 1);
+  if (type > 1 || length > BINARY_DESTINATION_SIZE) {
+    throw std::runtime_error("Malformed trace record " +
+                             std::to_string(nextId));
+  }
+
+  arrival.ship.type = static_cast<ShipType>(type);
+  arrival.ship.destination.assign(record + 18, length);
+  arrival.ship.id = nextId++;
+  arrival.ship.needsInspection = false;
+
+  offset += BINARY_RECORD_SIZE;
+  remaining--;
+  return true;
+}
+
+bool ArrivalTrace::nextCsv(Arrival& arrival) {
+  while (offset < size) {
+    const char* start = data + offset;
+    const char* end =
+        static_cast<const char*>(std::memchr(start, '\n', size - offset));
+    size_t length = end ? end - start : size - offset;
+    offset += length + (end != nullptr);
+    line++;
+
+    std::string_view rest(start, length);
+    if (!rest.empty() && rest.back() == '\r') {
+      rest.remove_suffix(1);
+    }
+    if (rest.empty()) {
+      continue;
+    }
+
+    std::string_view timeField = nextField(rest);
+    std::string_view typeField = nextField(rest);
+    std::string_view weightField = nextField(rest);
+    std::string_view destination = nextField(rest);
+
+    if (!parseDouble(timeField, arrival.time) ||
+        !parseType(typeField, arrival.ship.type) ||
+        !parseDouble(weightField, arrival.ship.avgWeight) ||
+        destination.empty() || destination.size() > CSV_DESTINATION_SIZE) {
+      if (line == 1) {
+        continue;  // a header
+      }
+      throw std::runtime_error("Malformed trace line " +
+                               std::to_string(line));
+    }
+
+    arrival.ship.destination.assign(destination);
+    arrival.ship.id = nextId++;
+    arrival.ship.needsInspection = false;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "types.hpp"
+
+namespace ecuafast {
+// A ship and when it reaches the port, in seconds from the start of the
+// trace
+struct Arrival {
+  double time = 0.0;
+  ShipInfo ship{};
+};
+
+// Recorded arrivals read straight out of a memory-mapped file, one at a
+// time, so a trace of millions of ships costs no more memory than the pages
+// the kernel keeps cached. Ships get ids 0, 1, 2... in file order. Two
+// layouts are accepted:
+//
+// CSV, one ship per line, an optional header line first:
+//   time,type,weight,destination
+//   0.0,conventional,61234.5,Ecuador
+// where type is conventional, panamax, 0 or 1.
+//
+// Binary, native-endian: the 8 bytes "EFTRACE1", a uint64 record count,
+// then 32-byte records of {double time; double weight; uint8 type;
+// uint8 destinationLength; char destination[14]}.
+//
+// Times should not decrease; consumers treat an earlier time as "now".
+class ArrivalTrace {
+ public:
+  // Throws std::runtime_error if the file cannot be mapped
+  explicit ArrivalTrace(const std::string& path);
+  ~ArrivalTrace();
+
+  ArrivalTrace(const ArrivalTrace&) = delete;
+  ArrivalTrace& operator=(const ArrivalTrace&) = delete;
+
+  // False at the end of the trace. Throws std::runtime_error on a
+  // malformed entry.
+  bool next(Arrival& arrival);
+
+ private:
+  const char* data = nullptr;
+  size_t size = 0;
+  size_t offset = 0;
+  bool binary = false;
+  uint64_t remaining = 0;  // binary records left
+  size_t line = 0;         // CSV line just read, for errors
+  int nextId = 0;
+
+  bool nextBinary(Arrival& arrival);
+  bool nextCsv(Arrival& arrival);
+};
+}  // namespace ecuafast
@@ -0,0 +1,71 @@
+#include "async_stream.hpp"
+
+#include <exception>
+#include <utility>
+
+namespace ecuafast {
+
+AsyncStream::AsyncStream(Transport& transport, EventLoop& loop)
+    : transport(transport),
+      eventLoop(loop),
+      inbox(std::make_shared<Inbox>()) {}
+
+AsyncStream::~AsyncStream() { close(); }
+
+bool AsyncStream::connect(int port) {
+  try {
+    stream = transport.connect(eventLoop, port);
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  // The stream lives on our loop, so its handlers run on this thread
+  std::shared_ptr<Inbox> shared = inbox;
+  stream->start(
+      [shared](const std::shared_ptr<MessageStream>&,
+               const std::string& message) {
+        shared->messages.push_back(message);
+        shared->wake();
+      },
+      [shared](const std::shared_ptr<MessageStream>&) {
+        shared->closed = true;
+        shared->wake();
+      });
+  return true;
+}
+
+void AsyncStream::send(const std::string& message) {
+  if (stream) {
+    stream->send(message);
+  }
+}
+
+Task<bool> AsyncStream::recv(std::string& message) {
+  // Keeps the inbox alive even if the stream is closed while we wait
+  std::shared_ptr<Inbox> shared = inbox;
+
+  while (shared->messages.empty() && !shared->closed && stream) {
+    co_await Arrival(*shared);
+  }
+
+  if (shared->messages.empty()) {
+    co_return false;
+  }
+  message = std::move(shared->messages.front());
+  shared->messages.pop_front();
+  co_return true;
+}
+
+void AsyncStream::close() {
+  if (stream) {
+    stream->close();
+  }
+}
+
+void AsyncStream::Inbox::wake() {
+  if (auto handle = std::exchange(waiter, {})) {
+    handle.resume();
+  }
+}
+
+}  // namespace ecuafast
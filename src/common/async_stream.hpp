@@ -0,0 +1,62 @@
+#pragma once
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "event_loop.hpp"
+#include "task.hpp"
+#include "transport.hpp"
+
+namespace ecuafast {
+// Client stream for coroutines running on one EventLoop. Sends are queued
+// by the stream and never suspend; incoming messages are buffered until
+// recv() asks for them. Everything, including close and destruction, must
+// happen on the loop thread, with at most one recv outstanding.
+class AsyncStream {
+ public:
+  AsyncStream(Transport& transport, EventLoop& loop);
+  ~AsyncStream();
+
+  AsyncStream(const AsyncStream&) = delete;
+  AsyncStream& operator=(const AsyncStream&) = delete;
+
+  // False if nothing listens on the port; later failures surface as a
+  // closed stream
+  bool connect(int port);
+  void send(const std::string& message);
+  // Returns false once the stream is closed and nothing is left to read
+  Task<bool> recv(std::string& message);
+  void close();
+
+  bool isOpen() const { return stream && !stream->isClosed(); }
+
+ private:
+  // Shared with the stream's handlers, which may outlive this object
+  struct Inbox {
+    std::deque<std::string> messages;
+    bool closed = false;
+    std::coroutine_handle<> waiter;
+
+    void wake();
+  };
+
+  class Arrival {
+   public:
+    explicit Arrival(Inbox& inbox) : inbox(inbox) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+      inbox.waiter = handle;
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    Inbox& inbox;
+  };
+
+  Transport& transport;
+  EventLoop& eventLoop;
+  std::shared_ptr<MessageStream> stream;
+  std::shared_ptr<Inbox> inbox;
+};
+}  // namespace ecuafast
@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <mutex>
+
+namespace ecuafast {
+// Stops callers from piling onto an endpoint that keeps failing. After
+// `failureThreshold` failures in a row the breaker opens and refuses every
+// request for `cooldown`; then it lets a single probe through (half-open),
+// whose outcome either closes it again or reopens it for another cooldown.
+// A probe nobody reports on within a cooldown counts as lost, and the next
+// caller probes instead, so a dropped probe cannot wedge the breaker.
+class CircuitBreaker {
+ public:
+  using Clock = std::chrono::steady_clock;
+  enum class State { CLOSED, OPEN, HALF_OPEN };
+
+  CircuitBreaker(int failureThreshold, Clock::duration cooldown)
+      : failureThreshold(failureThreshold > 0 ? failureThreshold : 1),
+        cooldown(cooldown) {}
+
+  bool allowRequest() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    switch (current) {
+      case State::CLOSED:
+        return true;
+      case State::OPEN:
+        if (Clock::now() < reopenAt) {
+          return false;
+        }
+        current = State::HALF_OPEN;
+        reopenAt = Clock::now() + cooldown;  // probe deadline
+        return true;  // this caller is the probe
+      case State::HALF_OPEN:
+        if (Clock::now() < reopenAt) {
+          return false;  // probe still outstanding
+        }
+        reopenAt = Clock::now() + cooldown;
+        return true;  // the last probe was lost; this caller replaces it
+    }
+    return false;
+  }
+
+  void recordSuccess() {
+    std::lock_guard<std::mutex> lock(mutex);
+    failures = 0;
+    current = State::CLOSED;
+  }
+
+  void recordFailure() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (current == State::HALF_OPEN || ++failures >= failureThreshold) {
+      current = State::OPEN;
+      reopenAt = Clock::now() + cooldown;
+      failures = 0;
+    }
+  }
+
+  State state() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+  }
+
+ private:
+  const int failureThreshold;
+  const Clock::duration cooldown;
+
+  std::mutex mutex;
+  State current = State::CLOSED;
+  int failures = 0;
+  Clock::time_point reopenAt;  // end of the cooldown, or of the probe
+};
+}  // namespace ecuafast
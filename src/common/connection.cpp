@@ -0,0 +1,156 @@
+#include "connection.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace ecuafast {
+
+Connection::Connection(EventLoop& loop, int fd)
+    : eventLoop(loop), socketFd(fd) {}
+
+Connection::~Connection() {
+  if (!closed) {
+    ::close(socketFd);
+  }
+}
+
+void Connection::start(MessageHandler onMessage, CloseHandler onClose) {
+  messageHandler = std::move(onMessage);
+  closeHandler = std::move(onClose);
+
+  auto self = std::static_pointer_cast<Connection>(shared_from_this());
+  eventLoop.add(socketFd, EPOLLIN | EPOLLOUT | EPOLLRDHUP,
+                [self](uint32_t events) { self->handleEvents(events); });
+}
+
+void Connection::send(const std::string& message) {
+  if (!eventLoop.inLoopThread()) {
+    auto self = std::static_pointer_cast<Connection>(shared_from_this());
+    eventLoop.post([self, message]() { self->queueFrame(message); });
+    return;
+  }
+
+  queueFrame(message);
+}
+
+void Connection::queueFrame(const std::string& message) {
+  if (closed) {
+    return;
+  }
+
+  framing::appendFrame(output, message);
+  flush();
+}
+
+void Connection::closeAfterWrite() {
+  if (!eventLoop.inLoopThread()) {
+    auto self = std::static_pointer_cast<Connection>(shared_from_this());
+    eventLoop.post([self]() { self->closeAfterWrite(); });
+    return;
+  }
+
+  closing = true;
+  if (output.empty()) {
+    close();
+  }
+}
+
+void Connection::close() {
+  if (!eventLoop.inLoopThread()) {
+    auto self = std::static_pointer_cast<Connection>(shared_from_this());
+    eventLoop.post([self]() { self->close(); });
+    return;
+  }
+
+  if (closed) {
+    return;
+  }
+
+  closed = true;
+  auto self = std::static_pointer_cast<Connection>(shared_from_this());
+  eventLoop.remove(socketFd);
+  ::close(socketFd);
+
+  if (closeHandler) {
+    closeHandler(self);
+  }
+}
+
+void Connection::handleEvents(uint32_t events) {
+  if (events & EPOLLOUT) {
+    flush();
+  }
+
+  // Errors and hang-ups surface as a failed or empty read
+  if (!closed && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+    handleRead();
+  }
+}
+
+void Connection::handleRead() {
+  char buffer[4096];
+  bool peerClosed = false;
+
+  // Edge-triggered: drain the socket completely
+  while (true) {
+    ssize_t bytesRead = read(socketFd, buffer, sizeof(buffer));
+
+    if (bytesRead > 0) {
+      input.feed(buffer, bytesRead);
+    } else if (bytesRead == 0) {
+      peerClosed = true;
+      break;
+    } else if (errno == EINTR) {
+      continue;
+    } else {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        peerClosed = true;
+      }
+      break;
+    }
+  }
+
+  auto self = std::static_pointer_cast<Connection>(shared_from_this());
+  std::string message;
+
+  while (!closed && input.next(message)) {
+    if (messageHandler) {
+      messageHandler(self, message);
+    }
+  }
+
+  if (input.failed()) {
+    close();
+    return;
+  }
+
+  if (peerClosed && !closed) {
+    close();
+  }
+}
+
+void Connection::flush() {
+  while (!output.empty() && !closed) {
+    ssize_t bytesSent =
+        ::send(socketFd, output.data(), output.size(), MSG_NOSIGNAL);
+
+    if (bytesSent > 0) {
+      output.erase(0, bytesSent);
+    } else if (bytesSent < 0 && errno == EINTR) {
+      continue;
+    } else if (bytesSent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;  // EPOLLOUT will fire again once there is room
+    } else {
+      close();
+      return;
+    }
+  }
+
+  if (closing && output.empty()) {
+    close();
+  }
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,44 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "event_loop.hpp"
+#include "framing.hpp"
+#include "transport.hpp"
+
+namespace ecuafast {
+// Non-blocking socket bound to one EventLoop that exchanges length-prefixed
+// frames. Reads are reassembled into whole messages, so one read may carry
+// several pipelined requests or only part of one; writes are buffered until
+// the kernel accepts them. The loop owns the connection until it is closed.
+class Connection : public MessageStream {
+ public:
+  Connection(EventLoop& loop, int fd);
+  ~Connection() override;
+
+  void start(MessageHandler onMessage, CloseHandler onClose = nullptr) override;
+  void send(const std::string& message) override;
+  void closeAfterWrite() override;
+  void close() override;
+
+  EventLoop& loop() override { return eventLoop; }
+  int fd() const { return socketFd; }
+  bool isClosed() const override { return closed; }
+
+ private:
+  EventLoop& eventLoop;
+  int socketFd;
+  framing::FrameDecoder input;
+  std::string output;
+  bool closing = false;
+  bool closed = false;
+  MessageHandler messageHandler;
+  CloseHandler closeHandler;
+
+  void handleEvents(uint32_t events);
+  void handleRead();
+  void queueFrame(const std::string& message);
+  void flush();
+};
+}  // namespace ecuafast
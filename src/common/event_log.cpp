@@ -0,0 +1,67 @@
+#include "event_log.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "utils.hpp"
+
+namespace ecuafast {
+
+void EventLog::open(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex);
+  this->path = path;
+  origin = std::chrono::steady_clock::now();
+  entries.clear();
+  recording = true;
+}
+
+void EventLog::record(double time, int shipId, std::string event) {
+  if (!enabled()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.push_back({time, shipId, std::move(event)});
+}
+
+void EventLog::record(int shipId, std::string event) {
+  if (!enabled()) {
+    return;
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - origin;
+  record(elapsed.count() / utils::timeScale().load(), shipId,
+         std::move(event));
+}
+
+bool EventLog::close() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!recording.exchange(false)) {
+    return true;
+  }
+
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.time != b.time ? a.time < b.time
+                                             : a.shipId < b.shipId;
+                   });
+
+  std::ofstream file(path);
+  file << "time,ship,event\n" << std::fixed << std::setprecision(6);
+  for (const Entry& entry : entries) {
+    file << entry.time << "," << entry.shipId << "," << entry.event << "\n";
+  }
+  entries.clear();
+
+  file.close();
+  return !file.fail();
+}
+
+EventLog& eventLog() {
+  static EventLog log;
+  return log;
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ecuafast {
+// What happened to which ship and when, in simulated seconds, written out
+// sorted once the run is over so that two runs can be diffed line by line.
+// The simulation records virtual times; threaded runs record wall time
+// since open() divided by the time scale. Recording is a no-op until open().
+class EventLog {
+ public:
+  // Starts recording; the file is written by close()
+  void open(const std::string& path);
+  bool enabled() const { return recording.load(std::memory_order_relaxed); }
+
+  void record(double time, int shipId, std::string event);
+  // Same, stamped with the simulated time elapsed since open()
+  void record(int shipId, std::string event);
+
+  // Sorts by time, then ship, keeping each ship's events in the order they
+  // were recorded. Returns false if the file could not be written.
+  bool close();
+
+ private:
+  struct Entry {
+    double time;
+    int shipId;
+    std::string event;
+  };
+
+  std::atomic<bool> recording{false};
+  std::string path;
+  std::chrono::steady_clock::time_point origin;
+  std::mutex mutex;
+  std::vector<Entry> entries;
+};
+
+// The run's log, shared like the time scale
+EventLog& eventLog();
+}  // namespace ecuafast
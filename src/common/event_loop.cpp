@@ -0,0 +1,211 @@
+#include "event_loop.hpp"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+
+namespace ecuafast {
+
+EventLoop::EventLoop() : running(true) {
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) {
+    throw std::runtime_error("Failed to create epoll instance");
+  }
+
+  wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeFd < 0) {
+    close(epollFd);
+    throw std::runtime_error("Failed to create eventfd");
+  }
+
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = wakeFd;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+EventLoop::~EventLoop() {
+  close(wakeFd);
+  close(epollFd);
+}
+
+void EventLoop::run() {
+  loopThread = std::this_thread::get_id();
+
+  std::vector<epoll_event> events(256);
+
+  while (running) {
+    int ready = epoll_wait(epollFd, events.data(),
+                           static_cast<int>(events.size()), nextTimeoutMs());
+
+    if (ready < 0 && errno != EINTR) {
+      break;
+    }
+
+    for (int i = 0; i < ready; ++i) {
+      int fd = events[i].data.fd;
+
+      if (fd == wakeFd) {
+        uint64_t counter;
+        while (read(wakeFd, &counter, sizeof(counter)) > 0) {
+        }
+        continue;
+      }
+
+      // Keep the handler alive even if it removes itself
+      auto it = handlers.find(fd);
+      if (it != handlers.end()) {
+        std::shared_ptr<IoHandler> handler = it->second;
+        (*handler)(events[i].events);
+      }
+    }
+
+    runExpiredTimers();
+    runPendingTasks();
+  }
+}
+
+void EventLoop::stop() {
+  running = false;
+  wakeup();
+}
+
+void EventLoop::post(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pendingTasks.push_back(std::move(task));
+  }
+  wakeup();
+}
+
+void EventLoop::runAfter(Clock::duration delay, Task task) {
+  Clock::time_point when = Clock::now() + delay;
+
+  if (!inLoopThread()) {
+    post([this, when, task = std::move(task)]() mutable {
+      timers.push({when, timerSeq++, std::move(task)});
+    });
+    return;
+  }
+
+  timers.push({when, timerSeq++, std::move(task)});
+}
+
+void EventLoop::add(int fd, uint32_t events, IoHandler handler) {
+  if (!inLoopThread()) {
+    post([this, fd, events, handler = std::move(handler)]() mutable {
+      add(fd, events, std::move(handler));
+    });
+    return;
+  }
+
+  handlers[fd] = std::make_shared<IoHandler>(std::move(handler));
+
+  epoll_event ev{};
+  ev.events = events | EPOLLET;
+  ev.data.fd = fd;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+void EventLoop::remove(int fd) {
+  if (!inLoopThread()) {
+    post([this, fd]() { remove(fd); });
+    return;
+  }
+
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+  handlers.erase(fd);
+}
+
+void EventLoop::removeAndClose(int fd) {
+  if (!inLoopThread()) {
+    post([this, fd]() { removeAndClose(fd); });
+    return;
+  }
+
+  remove(fd);
+  close(fd);
+}
+
+bool EventLoop::inLoopThread() const {
+  return loopThread.load() == std::this_thread::get_id();
+}
+
+void EventLoop::wakeup() {
+  uint64_t one = 1;
+  write(wakeFd, &one, sizeof(one));
+}
+
+void EventLoop::runPendingTasks() {
+  std::vector<Task> tasks;
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    tasks.swap(pendingTasks);
+  }
+
+  for (auto& task : tasks) {
+    task();
+  }
+}
+
+int EventLoop::nextTimeoutMs() {
+  {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (!pendingTasks.empty()) {
+      return 0;
+    }
+  }
+
+  if (timers.empty()) {
+    return -1;
+  }
+
+  auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+      timers.top().when - Clock::now());
+  return remaining.count() > 0 ? static_cast<int>(remaining.count()) : 0;
+}
+
+void EventLoop::runExpiredTimers() {
+  Clock::time_point now = Clock::now();
+
+  while (!timers.empty() && timers.top().when <= now) {
+    Task task = std::move(const_cast<Timer&>(timers.top()).task);
+    timers.pop();
+    task();
+  }
+}
+
+Reactor::Reactor(int threads) {
+  if (threads < 1) {
+    threads = 1;
+  }
+
+  for (int i = 0; i < threads; ++i) {
+    loops.push_back(std::make_unique<EventLoop>());
+  }
+
+  for (auto& loop : loops) {
+    EventLoop* raw = loop.get();
+    this->threads.emplace_back([raw]() { raw->run(); });
+  }
+}
+
+Reactor::~Reactor() {
+  for (auto& loop : loops) {
+    loop->stop();
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+EventLoop& Reactor::nextLoop() {
+  return *loops[next.fetch_add(1, std::memory_order_relaxed) % loops.size()];
+}
+
+size_t Reactor::size() const { return loops.size(); }
+
+}  // namespace ecuafast
@@ -0,0 +1,86 @@
+#pragma once
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ecuafast {
+// Single-threaded edge-triggered epoll loop. Handlers and timers always run on
+// the loop thread; post() and runAfter() may be called from any thread.
+class EventLoop {
+ public:
+  using Task = std::function<void()>;
+  using IoHandler = std::function<void(uint32_t events)>;
+  using Clock = std::chrono::steady_clock;
+
+  EventLoop();
+  ~EventLoop();
+
+  void run();
+  void stop();
+
+  void post(Task task);
+  void runAfter(Clock::duration delay, Task task);
+
+  void add(int fd, uint32_t events, IoHandler handler);
+  void remove(int fd);
+  // Stops watching fd and then closes it, both on the loop thread, so the
+  // number is never reused while the loop still maps it to a handler
+  void removeAndClose(int fd);
+
+  bool inLoopThread() const;
+
+ private:
+  struct Timer {
+    Clock::time_point when;
+    uint64_t seq;
+    Task task;
+  };
+
+  struct TimerLater {
+    bool operator()(const Timer& a, const Timer& b) const {
+      return a.when != b.when ? a.when > b.when : a.seq > b.seq;
+    }
+  };
+
+  int epollFd;
+  int wakeFd;
+  std::atomic<bool> running;
+  std::atomic<std::thread::id> loopThread;
+
+  std::unordered_map<int, std::shared_ptr<IoHandler>> handlers;
+  std::priority_queue<Timer, std::vector<Timer>, TimerLater> timers;
+  uint64_t timerSeq = 0;
+
+  std::mutex pendingMutex;
+  std::vector<Task> pendingTasks;
+
+  void wakeup();
+  void runPendingTasks();
+  int nextTimeoutMs();
+  void runExpiredTimers();
+};
+
+// Pool of event loops, each on its own thread. File descriptors are spread
+// across loops round-robin so that one connection always stays on one thread.
+class Reactor {
+ public:
+  explicit Reactor(int threads);
+  ~Reactor();
+
+  EventLoop& nextLoop();
+  size_t size() const;
+
+ private:
+  std::vector<std::unique_ptr<EventLoop>> loops;
+  std::vector<std::thread> threads;
+  std::atomic<size_t> next{0};
+};
+}  // namespace ecuafast
@@ -0,0 +1,131 @@
+#pragma once
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace ecuafast {
+namespace framing {
+// Every message on the wire is a 4-byte big-endian length followed by that
+// many payload bytes
+constexpr size_t HEADER_SIZE = 4;
+constexpr uint32_t MAX_FRAME_SIZE = 1 << 20;
+
+inline void appendFrame(std::string& out, const std::string& payload) {
+  uint32_t length = htonl(static_cast<uint32_t>(payload.size()));
+  out.append(reinterpret_cast<const char*>(&length), HEADER_SIZE);
+  out.append(payload);
+}
+
+inline std::string encodeFrame(const std::string& payload) {
+  std::string frame;
+  frame.reserve(HEADER_SIZE + payload.size());
+  appendFrame(frame, payload);
+  return frame;
+}
+
+// Incremental reassembly: bytes are fed as they arrive, in chunks of any
+// size, and complete payloads are popped one at a time
+class FrameDecoder {
+ public:
+  void feed(const char* data, size_t length) { buffer.append(data, length); }
+
+  // Returns false when no complete frame is buffered yet
+  bool next(std::string& payload) {
+    if (buffer.size() - offset < HEADER_SIZE) {
+      compact();
+      return false;
+    }
+
+    uint32_t length;
+    std::memcpy(&length, buffer.data() + offset, HEADER_SIZE);
+    length = ntohl(length);
+
+    if (length > MAX_FRAME_SIZE) {
+      corrupt = true;
+      return false;
+    }
+
+    if (buffer.size() - offset - HEADER_SIZE < length) {
+      compact();
+      return false;
+    }
+
+    payload.assign(buffer, offset + HEADER_SIZE, length);
+    offset += HEADER_SIZE + length;
+    return true;
+  }
+
+  // Set once a header announces a frame larger than MAX_FRAME_SIZE
+  bool failed() const { return corrupt; }
+
+ private:
+  std::string buffer;
+  size_t offset = 0;
+  bool corrupt = false;
+
+  void compact() {
+    if (offset > 0) {
+      buffer.erase(0, offset);
+      offset = 0;
+    }
+  }
+};
+
+// Blocking helpers for plain sockets
+inline bool sendFrame(int socket, const std::string& payload) {
+  std::string frame = encodeFrame(payload);
+  size_t sent = 0;
+
+  while (sent < frame.size()) {
+    ssize_t n =
+        ::send(socket, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    sent += n;
+  }
+
+  return true;
+}
+
+inline bool readExactly(int socket, char* data, size_t length) {
+  size_t received = 0;
+
+  while (received < length) {
+    ssize_t n = read(socket, data + received, length - received);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    received += n;
+  }
+
+  return true;
+}
+
+inline bool recvFrame(int socket, std::string& payload) {
+  uint32_t length;
+  if (!readExactly(socket, reinterpret_cast<char*>(&length), HEADER_SIZE)) {
+    return false;
+  }
+
+  length = ntohl(length);
+  if (length > MAX_FRAME_SIZE) {
+    return false;
+  }
+
+  payload.resize(length);
+  return readExactly(socket, payload.data(), length);
+}
+}  // namespace framing
+}  // namespace ecuafast
@@ -0,0 +1,65 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace ecuafast {
+// Per-ship service latencies under open-loop load, in simulated seconds.
+// The corrected latency runs from when a ship was due to arrive. The raw
+// one starts only when it actually set sail. When the generator or the
+// in-flight limit falls behind, only the corrected figure counts that
+// delay; the gap between the two is the coordinated omission a closed-loop
+// benchmark would hide.
+class LatencyRecorder {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void record(Clock::time_point due, Clock::time_point started,
+              Clock::time_point finished) {
+    double corrected = toSimulated(finished - due);
+    double raw = toSimulated(finished - started);
+    std::lock_guard<std::mutex> lock(mutex);
+    correctedLatencies.push_back(corrected);
+    rawLatencies.push_back(raw);
+  }
+
+  void report(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::sort(correctedLatencies.begin(), correctedLatencies.end());
+    std::sort(rawLatencies.begin(), rawLatencies.end());
+
+    out << "Latency over " << correctedLatencies.size()
+        << " ships, in simulated seconds\n"
+        << std::setw(11) << "" << std::setw(9) << "p50" << std::setw(9)
+        << "p90" << std::setw(9) << "p99" << std::setw(9) << "p99.9"
+        << std::setw(9) << "max" << "\n";
+    printRow(out, "corrected", correctedLatencies);
+    printRow(out, "raw", rawLatencies);
+  }
+
+ private:
+  std::mutex mutex;
+  std::vector<double> correctedLatencies;
+  std::vector<double> rawLatencies;
+
+  static double toSimulated(Clock::duration elapsed) {
+    return std::chrono::duration<double>(elapsed).count() /
+           utils::timeScale().load();
+  }
+
+  static void printRow(std::ostream& out, const char* label,
+                       const std::vector<double>& sorted) {
+    out << "  " << std::left << std::setw(9) << label << std::right
+        << std::fixed << std::setprecision(3);
+    for (double q : {0.50, 0.90, 0.99, 0.999, 1.0}) {
+      out << std::setw(9) << utils::percentile(sorted, q);
+    }
+    out << "\n";
+  }
+};
+}  // namespace ecuafast
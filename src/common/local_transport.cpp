@@ -0,0 +1,141 @@
+#include "local_transport.hpp"
+
+#include <stdexcept>
+
+namespace ecuafast {
+
+std::pair<std::shared_ptr<LocalStream>, std::shared_ptr<LocalStream>>
+LocalStream::connectPair(EventLoop& first, EventLoop& second) {
+  auto a = std::make_shared<LocalStream>(first);
+  auto b = std::make_shared<LocalStream>(second);
+  a->peer = b;
+  a->accepted = b;
+  b->peer = a;
+  return {a, b};
+}
+
+LocalStream::LocalStream(EventLoop& loop) : eventLoop(loop) {}
+
+LocalStream::~LocalStream() {
+  // Dropped without a close, like a socket whose last descriptor goes away
+  if (!closed) {
+    if (auto other = peer.lock()) {
+      other->deliver({"", true});
+    }
+  }
+}
+
+void LocalStream::start(MessageHandler onMessage, CloseHandler onClose) {
+  auto self = std::static_pointer_cast<LocalStream>(shared_from_this());
+
+  if (!eventLoop.inLoopThread()) {
+    eventLoop.post([self, onMessage = std::move(onMessage),
+                    onClose = std::move(onClose)]() mutable {
+      self->start(std::move(onMessage), std::move(onClose));
+    });
+    return;
+  }
+
+  messageHandler = std::move(onMessage);
+  closeHandler = std::move(onClose);
+  started = true;
+
+  // Messages may have arrived before the stream was started
+  drain();
+}
+
+void LocalStream::send(const std::string& message) {
+  if (closed) {
+    return;
+  }
+
+  if (auto other = peer.lock()) {
+    other->deliver({message, false});
+  }
+}
+
+void LocalStream::close() {
+  auto self = std::static_pointer_cast<LocalStream>(shared_from_this());
+
+  if (!eventLoop.inLoopThread()) {
+    eventLoop.post([self]() { self->close(); });
+    return;
+  }
+
+  if (closed.exchange(true)) {
+    return;
+  }
+
+  if (auto other = peer.lock()) {
+    other->deliver({"", true});
+  }
+
+  if (closeHandler) {
+    closeHandler(self);
+  }
+}
+
+void LocalStream::deliver(Item item) {
+  inbox.push(std::move(item));
+
+  // Only the push that finds the inbox idle wakes the loop
+  if (!drainScheduled.exchange(true)) {
+    auto self = std::static_pointer_cast<LocalStream>(shared_from_this());
+    eventLoop.post([self]() { self->drain(); });
+  }
+}
+
+void LocalStream::drain() {
+  // Cleared before popping: a push that misses this pass schedules the next
+  drainScheduled.exchange(false);
+
+  if (!started && !closed) {
+    return;  // start() drains once the handlers are in place
+  }
+
+  auto self = shared_from_this();
+  Item item;
+  while (inbox.pop(item)) {
+    if (closed) {
+      continue;  // discarded, as a closed socket would
+    }
+    if (item.hangUp) {
+      close();
+    } else if (messageHandler) {
+      messageHandler(self, item.message);
+    }
+  }
+}
+
+void LocalTransport::listen(int port, Reactor& reactor,
+                            AcceptHandler onAccept) {
+  std::lock_guard<std::mutex> lock(listenersMutex);
+  if (!listeners.emplace(port, Listener{&reactor, std::move(onAccept)})
+           .second) {
+    throw std::runtime_error("Failed to bind socket");
+  }
+}
+
+std::shared_ptr<MessageStream> LocalTransport::connect(EventLoop& loop,
+                                                       int port) {
+  Listener listener;
+  {
+    std::lock_guard<std::mutex> lock(listenersMutex);
+    auto it = listeners.find(port);
+    if (it == listeners.end()) {
+      throw std::runtime_error("Connection failed");
+    }
+    listener = it->second;
+  }
+
+  EventLoop& serverLoop = listener.reactor->nextLoop();
+  auto [client, server] = LocalStream::connectPair(loop, serverLoop);
+
+  // Anything the client sends meanwhile waits in the server end's inbox
+  serverLoop.post([onAccept = std::move(listener.onAccept), server]() {
+    onAccept(server);
+  });
+  return client;
+}
+
+}  // namespace ecuafast
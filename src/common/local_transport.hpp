@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "event_loop.hpp"
+#include "mpsc_queue.hpp"
+#include "transport.hpp"
+
+namespace ecuafast {
+// One end of an in-process stream. send() moves the message straight into
+// the peer's lock-free inbox from whatever thread calls it; the peer's loop
+// is only posted to when its inbox goes from idle to busy, so a burst of
+// messages costs one wakeup and no copies through the kernel. Unlike a
+// socket, a stream lives only as long as it is referenced: the connecting
+// end holds the accepted one, so dropping a client tears down both.
+class LocalStream : public MessageStream {
+ public:
+  // Two connected ends on their own loops; the first one owns the second
+  static std::pair<std::shared_ptr<LocalStream>, std::shared_ptr<LocalStream>>
+  connectPair(EventLoop& first, EventLoop& second);
+
+  explicit LocalStream(EventLoop& loop);
+  ~LocalStream() override;
+
+  void start(MessageHandler onMessage, CloseHandler onClose = nullptr) override;
+  void send(const std::string& message) override;
+  // Sends are handed over immediately, so there is nothing left to flush
+  void closeAfterWrite() override { close(); }
+  void close() override;
+
+  EventLoop& loop() override { return eventLoop; }
+  bool isClosed() const override { return closed; }
+
+ private:
+  // A message, or the peer hanging up after everything it sent before
+  struct Item {
+    std::string message;
+    bool hangUp = false;
+  };
+
+  EventLoop& eventLoop;
+  std::weak_ptr<LocalStream> peer;
+  std::shared_ptr<LocalStream> accepted;
+  MpscQueue<Item> inbox;
+  std::atomic<bool> drainScheduled{false};
+  std::atomic<bool> closed{false};
+  bool started = false;
+  MessageHandler messageHandler;
+  CloseHandler closeHandler;
+
+  void deliver(Item item);
+  void drain();
+};
+
+// Streams between threads of this process, with no sockets at all: no
+// system calls beyond loop wakeups, no file descriptors and no ephemeral
+// ports to run out of. Ports are just names in a table.
+class LocalTransport : public Transport {
+ public:
+  void listen(int port, Reactor& reactor, AcceptHandler onAccept) override;
+  std::shared_ptr<MessageStream> connect(EventLoop& loop, int port) override;
+
+ private:
+  struct Listener {
+    Reactor* reactor;
+    AcceptHandler onAccept;
+  };
+
+  std::unordered_map<int, Listener> listeners;
+  std::mutex listenersMutex;
+};
+}  // namespace ecuafast
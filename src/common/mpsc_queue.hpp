@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace ecuafast {
+// Unbounded lock-free queue for many producers and a single consumer
+// (Vyukov's node-based design). A push is one atomic exchange plus a store,
+// so producers never wait on each other or on the consumer. A push that has
+// swung the head but not yet linked its node is not visible to pop() until
+// it finishes; callers that signal the consumer must do so after push().
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head(new Node()), tail(head.load(std::memory_order_relaxed)) {}
+
+  ~MpscQueue() {
+    T value;
+    while (pop(value)) {
+    }
+    delete tail;
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Any thread
+  void push(T value) {
+    Node* node = new Node(std::move(value));
+    Node* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  // Consumer thread only; returns false when nothing is linked in yet
+  bool pop(T& value) {
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return false;
+    }
+
+    // The old stub goes away and `next` becomes the new one
+    value = std::move(next->value);
+    delete tail;
+    tail = next;
+    return true;
+  }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    T value;
+
+    Node() = default;
+    explicit Node(T value) : value(std::move(value)) {}
+  };
+
+  alignas(64) std::atomic<Node*> head;
+  alignas(64) Node* tail;
+};
+}  // namespace ecuafast
@@ -0,0 +1,118 @@
+#include "quantile.hpp"
+
+#include <algorithm>
+
+namespace ecuafast {
+
+OrderStatisticQuantile::OrderStatisticQuantile(double q) : q(q) {}
+
+void OrderStatisticQuantile::insert(double value) {
+  values.insert({value, nextSeq++});
+}
+
+double OrderStatisticQuantile::value() const {
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  size_t idx = std::min(static_cast<size_t>(values.size() * q),
+                        values.size() - 1);
+  return values.find_by_order(idx)->first;
+}
+
+P2Quantile::P2Quantile(double q) : q(q) {
+  increments = {0.0, q / 2, q, (1 + q) / 2, 1.0};
+}
+
+void P2Quantile::insert(double value) {
+  // Until five samples exist the markers are just the sorted samples
+  if (count < 5) {
+    heights[count++] = value;
+    std::sort(heights.begin(), heights.begin() + count);
+
+    if (count == 5) {
+      positions = {0, 1, 2, 3, 4};
+      desired = {0, 2 * q, 4 * q, 2 + 2 * q, 4};
+    }
+    return;
+  }
+
+  int k;
+  if (value < heights[0]) {
+    heights[0] = value;
+    k = 0;
+  } else if (value >= heights[4]) {
+    heights[4] = value;
+    k = 3;
+  } else {
+    k = 0;
+    while (k < 3 && value >= heights[k + 1]) {
+      k++;
+    }
+  }
+
+  for (int i = k + 1; i < 5; ++i) {
+    positions[i] += 1;
+  }
+  for (int i = 0; i < 5; ++i) {
+    desired[i] += increments[i];
+  }
+  count++;
+
+  // Nudge the three middle markers towards their desired positions
+  for (int i = 1; i <= 3; ++i) {
+    double d = desired[i] - positions[i];
+
+    if ((d >= 1 && positions[i + 1] - positions[i] > 1) ||
+        (d <= -1 && positions[i - 1] - positions[i] < -1)) {
+      int step = d > 0 ? 1 : -1;
+      double candidate = parabolic(i, step);
+
+      if (heights[i - 1] < candidate && candidate < heights[i + 1]) {
+        heights[i] = candidate;
+      } else {
+        heights[i] = linear(i, step);
+      }
+      positions[i] += step;
+    }
+  }
+}
+
+double P2Quantile::value() const {
+  if (count == 0) {
+    return 0.0;
+  }
+
+  if (count < 5) {
+    size_t idx = std::min(static_cast<size_t>(count * q), count - 1);
+    return heights[idx];
+  }
+
+  return heights[2];
+}
+
+double P2Quantile::parabolic(int i, double d) const {
+  return heights[i] +
+         d / (positions[i + 1] - positions[i - 1]) *
+             ((positions[i] - positions[i - 1] + d) *
+                  (heights[i + 1] - heights[i]) /
+                  (positions[i + 1] - positions[i]) +
+              (positions[i + 1] - positions[i] - d) *
+                  (heights[i] - heights[i - 1]) /
+                  (positions[i] - positions[i - 1]));
+}
+
+double P2Quantile::linear(int i, int d) const {
+  return heights[i] + d * (heights[i + d] - heights[i]) /
+                          (positions[i + d] - positions[i]);
+}
+
+std::unique_ptr<QuantileEstimator> makeQuantileEstimator(QuantileMode mode,
+                                                         double q) {
+  if (mode == QuantileMode::APPROXIMATE) {
+    return std::make_unique<P2Quantile>(q);
+  }
+  return std::make_unique<OrderStatisticQuantile>(q);
+}
+
+}  // namespace ecuafast
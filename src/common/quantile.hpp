@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace ecuafast {
+enum class QuantileMode { EXACT, APPROXIMATE };
+
+// Running estimate of a single quantile over every value inserted so far
+class QuantileEstimator {
+ public:
+  virtual ~QuantileEstimator() = default;
+  virtual void insert(double value) = 0;
+  virtual double value() const = 0;
+  virtual size_t size() const = 0;
+};
+
+// Exact quantile backed by an order-statistics tree: O(log n) insert and
+// rank lookup. Returns the same element as sorting and indexing n * q.
+class OrderStatisticQuantile : public QuantileEstimator {
+ public:
+  explicit OrderStatisticQuantile(double q);
+
+  void insert(double value) override;
+  double value() const override;
+  size_t size() const override { return values.size(); }
+
+ private:
+  // The sequence number keeps duplicate weights as distinct keys
+  using Key = std::pair<double, uint64_t>;
+  using Tree =
+      __gnu_pbds::tree<Key, __gnu_pbds::null_type, std::less<Key>,
+                       __gnu_pbds::rb_tree_tag,
+                       __gnu_pbds::tree_order_statistics_node_update>;
+
+  double q;
+  uint64_t nextSeq = 0;
+  Tree values;
+};
+
+// Approximate quantile using the P-square algorithm (Jain & Chlamtac), which
+// tracks five markers and therefore needs constant memory and time.
+class P2Quantile : public QuantileEstimator {
+ public:
+  explicit P2Quantile(double q);
+
+  void insert(double value) override;
+  double value() const override;
+  size_t size() const override { return count; }
+
+ private:
+  double q;
+  size_t count = 0;
+  std::array<double, 5> heights{};
+  std::array<double, 5> positions{};
+  std::array<double, 5> desired{};
+  std::array<double, 5> increments{};
+
+  double parabolic(int i, double d) const;
+  double linear(int i, int d) const;
+};
+
+std::unique_ptr<QuantileEstimator> makeQuantileEstimator(QuantileMode mode,
+                                                         double q);
+}  // namespace ecuafast
@@ -0,0 +1,316 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ecuafast {
+// SplitMix64 step: a bijective mixer that turns counters into well spread
+// 64-bit values. Used to seed generators, never to draw from directly.
+inline uint64_t splitMix64(uint64_t& state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// xoshiro256**: 32 bytes of state, a handful of shifts and one multiply
+// per draw. Each (seed, stream) pair names an independent substream, so
+// threads or simulated objects can draw without sharing anything and a run
+// can be replayed from its seed. Satisfies UniformRandomBitGenerator.
+class Random {
+ public:
+  using result_type = uint64_t;
+
+  explicit Random(uint64_t seed = 0, uint64_t stream = 0) {
+    reseed(seed, stream);
+  }
+
+  void reseed(uint64_t seed, uint64_t stream = 0) {
+    // Mix the stream number in before expanding, so neighbouring streams
+    // start from unrelated states
+    uint64_t counter = stream;
+    uint64_t mixer = seed ^ splitMix64(counter);
+    for (uint64_t& word : state) {
+      word = splitMix64(mixer);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t shifted = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= shifted;
+    state[3] = rotl(state[3], 45);
+    return result;
+  }
+
+  // Uniform in [0, 1) from the top 53 bits
+  double uniform() { return ((*this)() >> 11) * 0x1.0p-53; }
+
+  // Uniform in [min, max], without modulo bias (Lemire's method)
+  int uniformInt(int min, int max) {
+    uint64_t range =
+        static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+    unsigned __int128 product =
+        static_cast<unsigned __int128>((*this)()) * range;
+    uint64_t low = static_cast<uint64_t>(product);
+    if (low < range) {
+      uint64_t threshold = -range % range;
+      while (low < threshold) {
+        product = static_cast<unsigned __int128>((*this)()) * range;
+        low = static_cast<uint64_t>(product);
+      }
+    }
+    return static_cast<int>(min + static_cast<int64_t>(product >> 64));
+  }
+
+ private:
+  uint64_t state[4];
+
+  static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+};
+
+namespace random {
+// What a draw tied to one ship decides. Each kind has its own streams, so
+// drawing more of one never shifts the values of another.
+enum class Draw : uint64_t { SHIP = 1, DAMAGE, VERDICT, DELAY, BACKOFF };
+
+// Process-wide seed; every generator handed out below derives from it
+struct SeedState {
+  std::atomic<uint64_t> seed{std::random_device{}()};
+  std::atomic<uint64_t> epoch{0};
+  std::atomic<uint64_t> nextStream{0};
+  std::atomic<bool> fixed{false};
+};
+
+inline SeedState& seedState() {
+  static SeedState state;
+  return state;
+}
+
+inline uint64_t seed() { return seedState().seed.load(); }
+
+// True once setSeed() has been called: the run is meant to be replayable
+inline bool seeded() { return seedState().fixed.load(); }
+
+// An independent generator for some object keyed by `stream`, such as a
+// ship id; it draws the same values however threads are scheduled
+inline Random substream(uint64_t stream) { return Random(seed(), stream); }
+
+// This thread's generator: its own substream, so draws never contend.
+// Which thread gets which stream depends on start order.
+inline Random& local() {
+  struct Local {
+    uint64_t epoch = ~uint64_t{0};
+    Random generator;
+  };
+  thread_local Local local;
+
+  SeedState& state = seedState();
+  uint64_t epoch = state.epoch.load(std::memory_order_acquire);
+  if (local.epoch != epoch) {
+    local.epoch = epoch;
+    // Thread streams count down from the top, clear of object streams
+    uint64_t stream = ~state.nextStream.fetch_add(1);
+    local.generator.reseed(state.seed.load(), stream);
+  }
+  return local.generator;
+}
+
+// Draws for (kind, owner, ship) keys under one seed. Draw n of a key is a
+// pure function of (seed, key, n), so all a key keeps is how many it has
+// drawn. Counts are grouped by ship, sharded by ship id so threads drawing
+// for different ships stay off each other's locks, and dropped by forget().
+// Servers never learn when a ship has left, so each shard also keeps only
+// the ships that started drawing most recently: replays stay exact while
+// fewer than 64 * SHIPS_PER_SHARD ships are drawing at once.
+class KeyedStreams {
+ public:
+  explicit KeyedStreams(uint64_t seed = 0) : seed(seed) {}
+
+  template <typename Use>
+  auto draw(uint64_t key, Use use) {
+    uint32_t shipId = static_cast<uint32_t>(key);
+    uint64_t index;
+    {
+      Shard& shard = shardOf(shipId);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto [ship, added] = shard.ships.try_emplace(shipId);
+      if (added) {
+        ship->second.since = shard.nextSince++;
+        shard.arrivals.emplace_back(shipId, ship->second.since);
+        shard.evictOldest();
+      }
+      std::vector<Counter>& counters = ship->second.counters;
+      auto it = std::find_if(counters.begin(), counters.end(),
+                             [key](const Counter& c) { return c.key == key; });
+      if (it == counters.end()) {
+        it = counters.insert(it, Counter{key, 0});
+      }
+      index = it->draws++;
+    }
+
+    uint64_t mixer = key;
+    Random random(seed, splitMix64(mixer) + index);
+    return use(random);
+  }
+
+  // Drops a ship's counts: its next draws start over from the first
+  void forget(uint32_t shipId) {
+    Shard& shard = shardOf(shipId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.ships.erase(shipId);
+  }
+
+  // Forgets every ship; callers make sure nobody is drawing
+  void reset(uint64_t seed) {
+    for (Shard& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.ships.clear();
+      shard.arrivals.clear();
+    }
+    this->seed = seed;
+  }
+
+ private:
+  // A ship has a handful of keys, one per kind and owner it draws for
+  struct Counter {
+    uint64_t key;
+    uint64_t draws;
+  };
+  struct Ship {
+    uint64_t since = 0;
+    std::vector<Counter> counters;
+  };
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<uint32_t, Ship> ships;
+    // Every ship in `ships` in the order it was added, plus some since
+    // forgotten; `since` tells a stale entry from a ship added again
+    std::deque<std::pair<uint32_t, uint64_t>> arrivals;
+    uint64_t nextSince = 0;
+
+    void evictOldest() {
+      while (arrivals.size() > SHIPS_PER_SHARD) {
+        auto [shipId, since] = arrivals.front();
+        arrivals.pop_front();
+        auto ship = ships.find(shipId);
+        if (ship != ships.end() && ship->second.since == since) {
+          ships.erase(ship);
+        }
+      }
+    }
+  };
+  static constexpr size_t SHIPS_PER_SHARD = 1024;
+  uint64_t seed;
+  std::array<Shard, 64> shards;
+
+  Shard& shardOf(uint32_t shipId) {
+    return shards[(shipId * 0x9e3779b97f4a7c15ULL) >> 58];
+  }
+};
+
+inline KeyedStreams& keyedStreams() {
+  static KeyedStreams streams;
+  return streams;
+}
+
+inline KeyedStreams*& scopedStreams() {
+  thread_local KeyedStreams* streams = nullptr;
+  return streams;
+}
+
+// While alive, keyed draws on this thread come from streams of its own seed
+// instead of the process-wide ones. Lets independent simulations share a
+// process, and ship ids, without sharing any generator.
+class Scope {
+ public:
+  explicit Scope(uint64_t seed)
+      : streams(seed), previous(std::exchange(scopedStreams(), &streams)) {}
+  ~Scope() { scopedStreams() = previous; }
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+ private:
+  KeyedStreams streams;
+  KeyedStreams* previous;
+};
+
+// Threads pick up a new seed on their next draw
+inline void setSeed(uint64_t seed) {
+  SeedState& state = seedState();
+  state.seed.store(seed);
+  state.nextStream.store(0);
+  state.fixed.store(true);
+  keyedStreams().reset(seed);
+  state.epoch.fetch_add(1);
+}
+
+// Keyed streams in effect on this thread, or null for the thread generator
+inline KeyedStreams* activeStreams() {
+  if (KeyedStreams* streams = scopedStreams()) {
+    return streams;
+  }
+  return seeded() ? &keyedStreams() : nullptr;
+}
+
+inline uint64_t streamKey(Draw kind, int shipId, int owner) {
+  return (static_cast<uint64_t>(kind) << 48) |
+         (static_cast<uint64_t>(owner & 0xffff) << 32) |
+         static_cast<uint32_t>(shipId);
+}
+
+// Drops a ship's keyed state once it has left. Kinds it never drew are
+// unaffected, so a one-off draw made afterwards (the port's damage draw)
+// still gives the same value.
+inline void forget(int shipId) {
+  if (KeyedStreams* streams = activeStreams()) {
+    streams->forget(static_cast<uint32_t>(shipId));
+  }
+}
+
+// The next draw in [0, 1) of `kind` for a ship, as seen by `owner` (an
+// entity port, or 0). Seeded runs give every ship the same sequence
+// whichever thread asks and whatever other ships do; otherwise this is just
+// the thread's generator.
+inline double uniform(Draw kind, int shipId, int owner = 0) {
+  KeyedStreams* streams = activeStreams();
+  if (!streams) {
+    return local().uniform();
+  }
+  return streams->draw(streamKey(kind, shipId, owner),
+                       [](Random& random) { return random.uniform(); });
+}
+
+// Same in [min, max]
+inline int uniformInt(Draw kind, int shipId, int min, int max,
+                      int owner = 0) {
+  KeyedStreams* streams = activeStreams();
+  if (!streams) {
+    return local().uniformInt(min, max);
+  }
+  return streams->draw(
+      streamKey(kind, shipId, owner),
+      [min, max](Random& random) { return random.uniformInt(min, max); });
+}
+}  // namespace random
+}  // namespace ecuafast
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace ecuafast {
+// Average of the last `capacity` values, kept in a ring buffer with a running
+// sum so that push() is O(1). Writers serialize on a mutex; readers load the
+// last published average from an atomic and never block.
+class RollingAverage {
+ public:
+  explicit RollingAverage(size_t capacity)
+      : window(capacity > 0 ? capacity : 1, 0.0) {}
+
+  void push(double value) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    append(value);
+    published.store(sum / count, std::memory_order_release);
+  }
+
+  // A whole batch under one lock, published once at the end
+  void push(std::span<const double> values) {
+    if (values.empty()) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(writeMutex);
+    for (double value : values) {
+      append(value);
+    }
+    published.store(sum / count, std::memory_order_release);
+  }
+
+  double average() const { return published.load(std::memory_order_acquire); }
+
+  size_t capacity() const { return window.size(); }
+
+ private:
+  std::vector<double> window;
+  size_t head = 0;
+  size_t count = 0;
+  size_t pushesSinceResync = 0;
+  double sum = 0.0;
+  std::mutex writeMutex;
+  std::atomic<double> published{0.0};
+
+  // Caller holds writeMutex
+  void append(double value) {
+    if (count == window.size()) {
+      sum -= window[head];
+    } else {
+      count++;
+    }
+
+    window[head] = value;
+    sum += value;
+    head = (head + 1) % window.size();
+
+    // Recompute from scratch once per lap so subtraction error can't build up
+    if (++pushesSinceResync >= window.size()) {
+      sum = 0.0;
+      for (size_t i = 0; i < count; ++i) {
+        sum += window[i];
+      }
+      pushesSinceResync = 0;
+    }
+  }
+};
+}  // namespace ecuafast
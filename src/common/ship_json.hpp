@@ -0,0 +1,302 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "types.hpp"
+
+namespace ecuafast {
+// Schema-specialized JSON for ShipInfo. The parser scans the buffer in place
+// and fills the struct directly, without building a DOM; the writer formats
+// straight into a caller-provided buffer. Only the five ShipInfo keys plus an
+// optional "requestId" are accepted, each at most once.
+namespace ship_json {
+constexpr size_t MAX_SIZE = 512;
+
+namespace detail {
+class Scanner {
+ public:
+  Scanner(const char* data, size_t length) : pos(data), end(data + length) {}
+
+  void skipSpace() {
+    while (pos < end &&
+           (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')) {
+      pos++;
+    }
+  }
+
+  bool consume(char c) {
+    skipSpace();
+    if (pos < end && *pos == c) {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+
+  bool atEnd() {
+    skipSpace();
+    return pos == end;
+  }
+
+  // Keys never need escapes, so they are returned as a view into the buffer
+  bool key(const char*& start, size_t& length) {
+    if (!consume('"')) {
+      return false;
+    }
+    start = pos;
+    while (pos < end && *pos != '"' && *pos != '\\') {
+      pos++;
+    }
+    if (pos == end || *pos != '"') {
+      return false;
+    }
+    length = pos - start;
+    pos++;
+    return true;
+  }
+
+  bool string(std::string& out) {
+    if (!consume('"')) {
+      return false;
+    }
+    out.clear();
+
+    while (pos < end && *pos != '"') {
+      char c = *pos++;
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return false;
+      }
+      if (c != '\\') {
+        out.push_back(c);
+        continue;
+      }
+      if (pos == end) {
+        return false;
+      }
+      switch (*pos++) {
+        case '"': out.push_back('"'); break;
+        case '\\': out.push_back('\\'); break;
+        case '/': out.push_back('/'); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        default: return false;  // \u escapes never occur in destinations
+      }
+    }
+
+    if (pos == end) {
+      return false;
+    }
+    pos++;
+    return true;
+  }
+
+  template <typename T>
+  bool number(T& out) {
+    skipSpace();
+    // from_chars would also take "inf" and "nan", which are not JSON
+    if (pos == end || !(*pos == '-' || (*pos >= '0' && *pos <= '9'))) {
+      return false;
+    }
+    auto result = std::from_chars(pos, end, out);
+    if (result.ec != std::errc() || result.ptr == pos) {
+      return false;
+    }
+    pos = result.ptr;
+    return true;
+  }
+
+  bool boolean(bool& out) {
+    skipSpace();
+    if (end - pos >= 4 && std::memcmp(pos, "true", 4) == 0) {
+      pos += 4;
+      out = true;
+      return true;
+    }
+    if (end - pos >= 5 && std::memcmp(pos, "false", 5) == 0) {
+      pos += 5;
+      out = false;
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  const char* pos;
+  const char* end;
+};
+
+inline bool keyIs(const char* key, size_t length, const char* expected) {
+  return length == std::strlen(expected) &&
+         std::memcmp(key, expected, length) == 0;
+}
+
+class Writer {
+ public:
+  Writer(char* buffer, size_t capacity)
+      : pos(buffer), start(buffer), end(buffer + capacity) {}
+
+  void raw(const char* text) {
+    size_t length = std::strlen(text);
+    if (static_cast<size_t>(end - pos) < length) {
+      overflow = true;
+      return;
+    }
+    std::memcpy(pos, text, length);
+    pos += length;
+  }
+
+  void character(char c) {
+    if (pos == end) {
+      overflow = true;
+      return;
+    }
+    *pos++ = c;
+  }
+
+  template <typename T>
+  void number(T value) {
+    auto result = std::to_chars(pos, end, value);
+    if (result.ec != std::errc()) {
+      overflow = true;
+      return;
+    }
+    pos = result.ptr;
+  }
+
+  void string(const std::string& value) {
+    character('"');
+    for (char c : value) {
+      switch (c) {
+        case '"': raw("\\\""); break;
+        case '\\': raw("\\\\"); break;
+        case '\n': raw("\\n"); break;
+        case '\r': raw("\\r"); break;
+        case '\t': raw("\\t"); break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            overflow = true;  // not representable without \u escapes
+            return;
+          }
+          character(c);
+      }
+    }
+    character('"');
+  }
+
+  size_t written() const { return overflow ? 0 : pos - start; }
+
+ private:
+  char* pos;
+  char* start;
+  char* end;
+  bool overflow = false;
+};
+}  // namespace detail
+
+// Returns false on malformed input, unknown or repeated keys, or missing
+// fields. requestId is optional in the input and left untouched if absent.
+inline bool parse(const char* data, size_t length, ShipInfo& ship,
+                  uint64_t* requestId = nullptr) {
+  detail::Scanner in(data, length);
+  enum : unsigned {
+    TYPE = 1,
+    WEIGHT = 2,
+    DESTINATION = 4,
+    ID = 8,
+    INSPECTION = 16,
+    REQUEST_ID = 32
+  };
+  unsigned seen = 0;
+
+  if (!in.consume('{')) {
+    return false;
+  }
+
+  if (!in.consume('}')) {
+    do {
+      const char* key;
+      size_t keyLength;
+      if (!in.key(key, keyLength) || !in.consume(':')) {
+        return false;
+      }
+
+      unsigned field;
+      bool ok;
+      if (detail::keyIs(key, keyLength, "type")) {
+        int type = 0;
+        field = TYPE;
+        ok = in.number(type) && (type == 0 || type == 1);
+        ship.type = static_cast<ShipType>(type);
+      } else if (detail::keyIs(key, keyLength, "avgWeight")) {
+        field = WEIGHT;
+        ok = in.number(ship.avgWeight);
+      } else if (detail::keyIs(key, keyLength, "destination")) {
+        field = DESTINATION;
+        ok = in.string(ship.destination);
+      } else if (detail::keyIs(key, keyLength, "id")) {
+        field = ID;
+        ok = in.number(ship.id);
+      } else if (detail::keyIs(key, keyLength, "needsInspection")) {
+        field = INSPECTION;
+        ok = in.boolean(ship.needsInspection);
+      } else if (detail::keyIs(key, keyLength, "requestId")) {
+        uint64_t id;
+        field = REQUEST_ID;
+        ok = in.number(id);
+        if (ok && requestId) {
+          *requestId = id;
+        }
+      } else {
+        return false;
+      }
+
+      if (!ok || (seen & field)) {
+        return false;
+      }
+      seen |= field;
+    } while (in.consume(','));
+
+    if (!in.consume('}')) {
+      return false;
+    }
+  }
+
+  constexpr unsigned required = TYPE | WEIGHT | DESTINATION | ID | INSPECTION;
+  return (seen & required) == required && in.atEnd();
+}
+
+inline bool parse(const std::string& message, ShipInfo& ship,
+                  uint64_t* requestId = nullptr) {
+  return parse(message.data(), message.size(), ship, requestId);
+}
+
+// Returns the number of bytes written, or 0 if the buffer is too small
+inline size_t write(const ShipInfo& ship, char* buffer, size_t capacity,
+                    const uint64_t* requestId = nullptr) {
+  detail::Writer out(buffer, capacity);
+
+  out.raw("{\"type\":");
+  out.number(static_cast<int>(ship.type));
+  out.raw(",\"avgWeight\":");
+  out.number(ship.avgWeight);
+  out.raw(",\"destination\":");
+  out.string(ship.destination);
+  out.raw(",\"id\":");
+  out.number(ship.id);
+  out.raw(",\"needsInspection\":");
+  out.raw(ship.needsInspection ? "true" : "false");
+  if (requestId) {
+    out.raw(",\"requestId\":");
+    out.number(*requestId);
+  }
+  out.character('}');
+
+  return out.written();
+}
+}  // namespace ship_json
+}  // namespace ecuafast
@@ -0,0 +1,477 @@
+#include "shm_transport.hpp"
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+namespace ecuafast {
+
+namespace {
+// Per direction. Every ship maps a region for its port manager stream and
+// mapping cost grows with the size, so rings stay small; a message that
+// can never fit closes the stream
+constexpr size_t RING_CAPACITY = 64 * 1024;
+constexpr size_t HEADER_SIZE = sizeof(uint32_t);
+
+// Abstract socket names need no file and vanish with the listener
+socklen_t listenerAddress(int port, sockaddr_un& address) {
+  std::string name = "ecuafast-shm-" + std::to_string(port);
+  address = {};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path + 1, name.data(), name.size());
+  return offsetof(sockaddr_un, sun_path) + 1 + name.size();
+}
+}  // namespace
+
+// Both directions of one stream, as laid out in the memfd. Positions only
+// grow; a message is a native-endian length followed by its bytes, wrapping
+// around the end of the buffer. All cross-process flags use seq_cst so the
+// waiting handshakes cannot both miss each other.
+struct SharedRegion {
+  struct Ring {
+    alignas(64) std::atomic<uint64_t> head{0};  // advanced by the consumer
+    alignas(64) std::atomic<uint64_t> tail{0};  // advanced by the producer
+    // Consumer is headed for epoll, or producer is waiting for room
+    alignas(64) std::atomic<uint32_t> readerWaiting{1};
+    std::atomic<uint32_t> writerWaiting{0};
+    std::atomic<uint32_t> closed{0};
+    alignas(64) char data[RING_CAPACITY];
+
+    bool write(const std::string& message) {
+      uint64_t position = tail.load(std::memory_order_relaxed);
+      uint64_t needed = HEADER_SIZE + message.size();
+      if (RING_CAPACITY - (position - head.load()) < needed) {
+        return false;
+      }
+
+      uint32_t length = message.size();
+      copyIn(position, &length, HEADER_SIZE);
+      copyIn(position + HEADER_SIZE, message.data(), message.size());
+      tail.store(position + needed);
+      return true;
+    }
+
+    // Returns false when empty; `corrupt` is set if the peer wrote garbage
+    bool read(std::string& message, bool& corrupt) {
+      uint64_t position = head.load(std::memory_order_relaxed);
+      uint64_t available = tail.load() - position;
+      if (available == 0) {
+        return false;
+      }
+
+      // Both the tail and the header come from the peer: a frame must fit
+      // in the ring, or copyOut would wrap round it past the buffer
+      uint32_t length = 0;
+      if (available <= RING_CAPACITY && available >= HEADER_SIZE) {
+        copyOut(position, &length, HEADER_SIZE);
+      }
+      if (available > RING_CAPACITY || available < HEADER_SIZE + length ||
+          length > RING_CAPACITY - HEADER_SIZE) {
+        corrupt = true;
+        return false;
+      }
+
+      message.resize(length);
+      copyOut(position + HEADER_SIZE, message.data(), length);
+      head.store(position + HEADER_SIZE + length);
+      return true;
+    }
+
+    bool empty() const { return head.load() == tail.load(); }
+
+    void copyIn(uint64_t position, const void* source, size_t length) {
+      size_t offset = position % RING_CAPACITY;
+      size_t first = std::min(length, RING_CAPACITY - offset);
+      std::memcpy(data + offset, source, first);
+      std::memcpy(data, static_cast<const char*>(source) + first,
+                  length - first);
+    }
+
+    void copyOut(uint64_t position, void* target, size_t length) const {
+      size_t offset = position % RING_CAPACITY;
+      size_t first = std::min(length, RING_CAPACITY - offset);
+      std::memcpy(target, data + offset, first);
+      std::memcpy(static_cast<char*>(target) + first, data,
+                  length - first);
+    }
+  };
+
+  // [0] carries messages from the connecting end, [1] the replies
+  Ring rings[2];
+};
+
+ShmStream::ShmStream(EventLoop& loop, int socketFd, SharedRegion* region)
+    : eventLoop(loop),
+      socketFd(socketFd),
+      region(region),
+      connecting(region != nullptr) {}
+
+ShmStream::~ShmStream() {
+  if (socketFd >= 0) {
+    ::close(socketFd);
+  }
+  if (region) {
+    munmap(region, sizeof(SharedRegion));
+  }
+}
+
+void ShmStream::start(MessageHandler onMessage, CloseHandler onClose) {
+  messageHandler = std::move(onMessage);
+  closeHandler = std::move(onClose);
+
+  auto self = std::static_pointer_cast<ShmStream>(shared_from_this());
+  eventLoop.add(socketFd, EPOLLIN | EPOLLRDHUP,
+                [self](uint32_t events) { self->handleEvents(events); });
+}
+
+void ShmStream::send(const std::string& message) {
+  if (message.size() > RING_CAPACITY - HEADER_SIZE) {
+    std::cerr << "Error: message of " << message.size()
+              << " bytes does not fit a shared-memory ring\n";
+    close();
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(sendMutex);
+  if (closed) {
+    return;
+  }
+
+  backlog.push_back(message);
+  flushBacklog();
+}
+
+bool ShmStream::flushBacklog() {
+  if (!region) {
+    return backlog.empty();  // the accepted end has no rings yet
+  }
+
+  SharedRegion::Ring& outbound = region->rings[connecting ? 0 : 1];
+  bool wrote = false;
+
+  while (!backlog.empty()) {
+    if (!outbound.write(backlog.front())) {
+      // Ask the consumer to ring back once it frees room, then look again
+      // in case it already did before seeing the flag
+      outbound.writerWaiting.store(1);
+      if (!outbound.write(backlog.front())) {
+        break;
+      }
+    }
+    backlog.pop_front();
+    wrote = true;
+  }
+
+  if (wrote && outbound.readerWaiting.exchange(0)) {
+    ringDoorbell();
+  }
+  return backlog.empty();
+}
+
+void ShmStream::closeAfterWrite() {
+  if (!eventLoop.inLoopThread()) {
+    auto self = shared_from_this();
+    eventLoop.post([self]() { self->closeAfterWrite(); });
+    return;
+  }
+
+  closing = true;
+  bool flushed;
+  {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    flushed = backlog.empty();
+  }
+  if (flushed) {
+    close();
+  }
+}
+
+void ShmStream::close() {
+  auto self = shared_from_this();
+
+  if (!eventLoop.inLoopThread()) {
+    eventLoop.post([self]() { self->close(); });
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    if (closed) {
+      return;
+    }
+    closed = true;
+
+    // Always rung: the peer must notice even if it is busy
+    if (region) {
+      region->rings[connecting ? 0 : 1].closed.store(1);
+    }
+    ringDoorbell();
+
+    eventLoop.remove(socketFd);
+    ::close(socketFd);
+    socketFd = -1;
+  }
+
+  if (closeHandler) {
+    closeHandler(self);
+  }
+}
+
+void ShmStream::handleEvents(uint32_t events) {
+  if (!region && !receiveRegion()) {
+    return;
+  }
+
+  // Doorbell bytes mean nothing beyond the wakeup itself
+  bool peerGone = events & (EPOLLHUP | EPOLLERR);
+  char buffer[256];
+  while (!closed) {
+    ssize_t bytesRead = read(socketFd, buffer, sizeof(buffer));
+    if (bytesRead > 0) {
+      continue;
+    }
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesRead == 0 ||
+        (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      peerGone = true;
+    }
+    break;
+  }
+
+  // Woken because the peer made room for our backlog, or to read
+  bool flushed;
+  {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    flushed = closed || flushBacklog();
+  }
+  if (closing && flushed) {
+    close();
+  }
+
+  // Whatever the peer wrote before it died or hung up is still delivered
+  drain();
+  if (peerGone && !closed) {
+    close();
+  }
+}
+
+bool ShmStream::receiveRegion() {
+  char byte;
+  iovec io{&byte, 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  msghdr message{};
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  ssize_t received;
+  do {
+    received = recvmsg(socketFd, &message, MSG_CMSG_CLOEXEC);
+  } while (received < 0 && errno == EINTR);
+
+  if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    return false;
+  }
+
+  cmsghdr* header = received > 0 ? CMSG_FIRSTHDR(&message) : nullptr;
+  if (!header || header->cmsg_level != SOL_SOCKET ||
+      header->cmsg_type != SCM_RIGHTS) {
+    close();
+    return false;
+  }
+
+  int memoryFd;
+  std::memcpy(&memoryFd, CMSG_DATA(header), sizeof(int));
+
+  struct stat info {};
+  void* mapped = MAP_FAILED;
+  if (fstat(memoryFd, &info) == 0 &&
+      static_cast<size_t>(info.st_size) >= sizeof(SharedRegion)) {
+    mapped = mmap(nullptr, sizeof(SharedRegion), PROT_READ | PROT_WRITE,
+                  MAP_SHARED, memoryFd, 0);
+  }
+  ::close(memoryFd);
+
+  if (mapped == MAP_FAILED) {
+    close();
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(sendMutex);
+  region = static_cast<SharedRegion*>(mapped);
+  return true;
+}
+
+void ShmStream::drain() {
+  SharedRegion::Ring& inbound = region->rings[connecting ? 1 : 0];
+  auto self = shared_from_this();
+  std::string message;
+  bool corrupt = false;
+
+  while (!closed) {
+    bool consumed = false;
+    while (!closed && inbound.read(message, corrupt)) {
+      consumed = true;
+      if (messageHandler) {
+        messageHandler(self, message);
+      }
+    }
+
+    if (consumed && inbound.writerWaiting.exchange(0)) {
+      std::lock_guard<std::mutex> lock(sendMutex);
+      if (!closed) {
+        ringDoorbell();
+      }
+    }
+
+    if (corrupt) {
+      close();
+      return;
+    }
+
+    // Raise the flag before the last look, so a producer either sees it
+    // and rings or wrote early enough for this look to find its message
+    inbound.readerWaiting.store(1);
+    if (inbound.empty()) {
+      break;
+    }
+    inbound.readerWaiting.store(0);
+  }
+
+  // The peer hung up after everything it sent
+  if (!closed && inbound.closed.load() && inbound.empty()) {
+    close();
+  }
+}
+
+void ShmStream::ringDoorbell() {
+  // A full socket buffer means the peer has wakeups pending anyway
+  char byte = 0;
+  ::send(socketFd, &byte, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+ShmTransport::~ShmTransport() {
+  std::lock_guard<std::mutex> lock(listenersMutex);
+  for (const Listener& listener : listeners) {
+    listener.loop->removeAndClose(listener.fd);
+  }
+}
+
+void ShmTransport::listen(int port, Reactor& reactor, AcceptHandler onAccept) {
+  int listenFd =
+      socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd < 0) {
+    throw std::runtime_error("Failed to create socket");
+  }
+
+  sockaddr_un address;
+  socklen_t length = listenerAddress(port, address);
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), length) < 0) {
+    ::close(listenFd);
+    throw std::runtime_error("Failed to bind socket");
+  }
+  if (::listen(listenFd, SOMAXCONN) < 0) {
+    ::close(listenFd);
+    throw std::runtime_error("Failed to listen on socket");
+  }
+
+  EventLoop& acceptLoop = reactor.nextLoop();
+  acceptLoop.add(listenFd, EPOLLIN, [listenFd, &reactor, onAccept](uint32_t) {
+    // Edge-triggered: accept until the backlog is empty
+    while (true) {
+      int clientSocket =
+          accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (clientSocket < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        return;
+      }
+      onAccept(std::make_shared<ShmStream>(reactor.nextLoop(), clientSocket,
+                                           nullptr));
+    }
+  });
+
+  std::lock_guard<std::mutex> lock(listenersMutex);
+  listeners.push_back({&acceptLoop, listenFd});
+}
+
+std::shared_ptr<MessageStream> ShmTransport::connect(EventLoop& loop,
+                                                     int port) {
+  // Non-blocking from the start: this runs on a loop thread. A local
+  // connect never waits; it fails with EAGAIN on a full backlog instead, and
+  // the first byte always fits in a fresh socket's buffer.
+  int clientSocket =
+      socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (clientSocket < 0) {
+    throw std::runtime_error("Failed to create socket");
+  }
+
+  sockaddr_un address;
+  socklen_t length = listenerAddress(port, address);
+  if (::connect(clientSocket, reinterpret_cast<sockaddr*>(&address), length) <
+      0) {
+    ::close(clientSocket);
+    throw std::runtime_error("Connection failed");
+  }
+
+  int memoryFd = memfd_create("ecuafast-stream", MFD_CLOEXEC);
+  void* mapped = MAP_FAILED;
+  if (memoryFd >= 0 && ftruncate(memoryFd, sizeof(SharedRegion)) == 0) {
+    mapped = mmap(nullptr, sizeof(SharedRegion), PROT_READ | PROT_WRITE,
+                  MAP_SHARED, memoryFd, 0);
+  }
+  if (mapped == MAP_FAILED) {
+    if (memoryFd >= 0) {
+      ::close(memoryFd);
+    }
+    ::close(clientSocket);
+    throw std::runtime_error("Failed to map shared memory");
+  }
+  auto* region = new (mapped) SharedRegion();
+
+  // The memfd rides along with the first byte; the accepted end maps it
+  char byte = 0;
+  iovec io{&byte, 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr message{};
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  cmsghdr* header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(header), &memoryFd, sizeof(int));
+
+  ssize_t sent;
+  do {
+    sent = sendmsg(clientSocket, &message, MSG_NOSIGNAL);
+  } while (sent < 0 && errno == EINTR);
+  ::close(memoryFd);
+
+  if (sent != 1) {
+    munmap(mapped, sizeof(SharedRegion));
+    ::close(clientSocket);
+    throw std::runtime_error("Connection failed");
+  }
+
+
+  return std::make_shared<ShmStream>(loop, clientSocket, region);
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "event_loop.hpp"
+#include "transport.hpp"
+
+namespace ecuafast {
+struct SharedRegion;
+
+// One end of a stream between processes on the same host. Messages travel
+// through a pair of single-producer rings in a memfd mapped by both ends;
+// the Unix socket the memfd was passed over stays open as a doorbell and to
+// notice the peer dying. A consumer with nothing to read raises a flag in
+// shared memory before it goes back to epoll, and a producer only rings the
+// doorbell when it finds that flag up, the way a futex skips the wake call
+// when nobody waits. A busy stream therefore moves messages without any
+// system call. Senders on several threads take turns on a local mutex.
+class ShmStream : public MessageStream {
+ public:
+  // The connecting end brings the region; the accepted end receives it
+  // over the socket before its first message
+  ShmStream(EventLoop& loop, int socketFd, SharedRegion* region);
+  ~ShmStream() override;
+
+  void start(MessageHandler onMessage, CloseHandler onClose = nullptr) override;
+  void send(const std::string& message) override;
+  void closeAfterWrite() override;
+  void close() override;
+
+  EventLoop& loop() override { return eventLoop; }
+  bool isClosed() const override { return closed; }
+
+ private:
+  EventLoop& eventLoop;
+  int socketFd;
+  SharedRegion* region;
+  bool connecting;
+  std::atomic<bool> closed{false};
+  bool closing = false;
+  MessageHandler messageHandler;
+  CloseHandler closeHandler;
+
+  // Messages the outbound ring had no room for, oldest first
+  std::mutex sendMutex;
+  std::deque<std::string> backlog;
+
+  void handleEvents(uint32_t events);
+  bool receiveRegion();
+  void drain();
+  // Caller holds sendMutex
+  bool flushBacklog();
+  void ringDoorbell();
+};
+
+// Shared-memory streams for processes on one host. A listener is an
+// abstract Unix socket named after the port; each connect creates a memfd
+// holding both rings and hands it over that socket.
+class ShmTransport : public Transport {
+ public:
+  ~ShmTransport() override;
+
+  void listen(int port, Reactor& reactor, AcceptHandler onAccept) override;
+  std::shared_ptr<MessageStream> connect(EventLoop& loop, int port) override;
+
+ private:
+  struct Listener {
+    EventLoop* loop;
+    int fd;
+  };
+
+  std::vector<Listener> listeners;
+  std::mutex listenersMutex;
+};
+}  // namespace ecuafast
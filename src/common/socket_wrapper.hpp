@@ -1,5 +1,6 @@
 #pragma once
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -31,7 +32,7 @@ class SocketWrapper {
       throw std::runtime_error("Failed to bind socket");
     }
 
-    if (listen(serverSocket, 10) < 0) {
+    if (listen(serverSocket, SOMAXCONN) < 0) {
       close(serverSocket);
       throw std::runtime_error("Failed to listen on socket");
     }
@@ -62,5 +63,12 @@ class SocketWrapper {
 
     return clientSocket;
   }
+
+  static void setNonBlocking(int socket) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags < 0 || fcntl(socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+      throw std::runtime_error("Failed to set socket non-blocking");
+    }
+  }
 };
 }  // namespace ecuafast
\ No newline at end of file
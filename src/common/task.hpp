@@ -0,0 +1,194 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <utility>
+
+namespace ecuafast {
+// Lazily started coroutine that produces a T. Awaiting a Task starts it and
+// resumes the awaiting coroutine once it finishes, through symmetric
+// transfer, so long chains of awaits do not grow the stack. Exceptions
+// propagate to the awaiter.
+template <typename T = void>
+class Task;
+
+namespace detail {
+struct PromiseBase {
+  std::coroutine_handle<> continuation = std::noop_coroutine();
+  std::exception_ptr error;
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> self) noexcept {
+      return self.promise().continuation;
+    }
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  FinalAwaiter final_suspend() noexcept { return {}; }
+  void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object();
+  void return_value(T result) { value = std::move(result); }
+
+  T take() {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return std::move(*value);
+  }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+  Task<void> get_return_object();
+  void return_void() {}
+
+  void take() {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+}  // namespace detail
+
+template <typename T>
+class Task {
+ public:
+  using promise_type = detail::Promise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  explicit Task(Handle handle) : coroutine(handle) {}
+  Task(Task&& other) noexcept : coroutine(std::exchange(other.coroutine, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (coroutine) {
+        coroutine.destroy();
+      }
+      coroutine = std::exchange(other.coroutine, {});
+    }
+    return *this;
+  }
+  ~Task() {
+    if (coroutine) {
+      coroutine.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) {
+    coroutine.promise().continuation = awaiter;
+    return coroutine;
+  }
+  T await_resume() { return coroutine.promise().take(); }
+
+ private:
+  Handle coroutine;
+};
+
+namespace detail {
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Owns itself: starts right away and frees its frame when it finishes
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+inline Detached runDetached(Task<> task) {
+  try {
+    co_await task;
+  } catch (const std::exception& e) {
+    std::cerr << "Unhandled error in task: " << e.what() << "\n";
+  }
+}
+
+// Result slot for a task running alongside its parent. Everything happens on
+// one thread, so awaiting it either finds the result ready or parks the
+// parent until set() resumes it; get() then returns or rethrows.
+template <typename T>
+class Pending {
+ public:
+  void set(std::optional<T> result, std::exception_ptr failure) {
+    value = std::move(result);
+    error = failure;
+    done = true;
+    // The parent may destroy this object once resumed
+    if (auto parent = std::exchange(waiter, {})) {
+      parent.resume();
+    }
+  }
+
+  bool await_ready() const noexcept { return done; }
+  void await_suspend(std::coroutine_handle<> parent) { waiter = parent; }
+  void await_resume() const noexcept {}
+
+  T get() {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return std::move(*value);
+  }
+
+ private:
+  std::optional<T> value;
+  std::exception_ptr error;
+  std::coroutine_handle<> waiter;
+  bool done = false;
+};
+
+template <typename T>
+Task<> capture(Task<T> task, Pending<T>& slot) {
+  std::optional<T> value;
+  std::exception_ptr failure;
+  try {
+    value = co_await task;
+  } catch (...) {
+    failure = std::current_exception();
+  }
+  slot.set(std::move(value), failure);
+}
+}  // namespace detail
+
+// Runs a task to completion without anyone awaiting it. The task runs on the
+// calling thread until its first suspension.
+inline void spawn(Task<> task) { detail::runDetached(std::move(task)); }
+
+// Runs both tasks concurrently and resumes once both have finished. All
+// resumptions must happen on the same thread, e.g. one EventLoop.
+template <typename A, typename B>
+Task<std::pair<A, B>> whenAll(Task<A> first, Task<B> second) {
+  detail::Pending<A> firstResult;
+  detail::Pending<B> secondResult;
+
+  spawn(detail::capture(std::move(first), firstResult));
+  spawn(detail::capture(std::move(second), secondResult));
+
+  // Both must finish before either result is looked at: a rethrow would
+  // otherwise free the slots while the other task still writes to them
+  co_await firstResult;
+  co_await secondResult;
+  co_return std::pair<A, B>(firstResult.get(), secondResult.get());
+}
+}  // namespace ecuafast
@@ -0,0 +1,75 @@
+#include "tcp_server.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+
+#include "socket_wrapper.hpp"
+
+namespace ecuafast {
+
+TcpServer::TcpServer(Reactor& reactor, int port,
+                     Transport::AcceptHandler onAccept)
+    : listener(std::make_shared<Listener>(reactor, std::move(onAccept))),
+      port(port) {}
+
+TcpServer::~TcpServer() {
+  listener->closed = true;
+  if (listener->fd >= 0) {
+    listener->loop.remove(listener->fd);
+  }
+}
+
+void TcpServer::start() {
+  listener->fd = SocketWrapper::createServerSocket(port);
+  SocketWrapper::setNonBlocking(listener->fd);
+
+  listener->loop.add(listener->fd, EPOLLIN,
+                     [listener = listener](uint32_t) {
+                       listener->acceptConnections();
+                     });
+}
+
+TcpServer::Listener::Listener(Reactor& reactor,
+                              Transport::AcceptHandler onAccept)
+    : reactor(reactor),
+      loop(reactor.nextLoop()),
+      acceptHandler(std::move(onAccept)) {}
+
+TcpServer::Listener::~Listener() {
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+void TcpServer::Listener::acceptConnections() {
+  // Edge-triggered: accept until the backlog is empty
+  while (!closed) {
+    sockaddr_in clientAddr{};
+    socklen_t clientLen = sizeof(clientAddr);
+    int clientSocket = accept4(fd, (struct sockaddr*)&clientAddr,
+                               &clientLen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (clientSocket < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+          errno == ENOMEM) {
+        // The backlog is not empty, so no new edge will come: try again
+        // once some descriptors may have been released
+        loop.runAfter(std::chrono::milliseconds(100),
+                      [self = shared_from_this()]() {
+                        self->acceptConnections();
+                      });
+      }
+      return;
+    }
+
+    acceptHandler(std::make_shared<Connection>(reactor.nextLoop(),
+                                               clientSocket));
+  }
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+#include "connection.hpp"
+#include "event_loop.hpp"
+#include "transport.hpp"
+
+namespace ecuafast {
+// Listening socket registered with a Reactor. Accepted connections are handed
+// to the reactor's loops round-robin and passed to the accept handler.
+class TcpServer {
+ public:
+  TcpServer(Reactor& reactor, int port, Transport::AcceptHandler onAccept);
+  ~TcpServer();
+
+  void start();
+
+ private:
+  // Owned jointly by the server, the loop's handler and any accept retry,
+  // so a listener event that fires after the server is gone still finds it.
+  // The last owner closes the socket, after the loop has stopped watching.
+  struct Listener : std::enable_shared_from_this<Listener> {
+    Listener(Reactor& reactor, Transport::AcceptHandler onAccept);
+    ~Listener();
+
+    Reactor& reactor;
+    EventLoop& loop;
+    int fd = -1;
+    std::atomic<bool> closed{false};
+    Transport::AcceptHandler acceptHandler;
+
+    void acceptConnections();
+  };
+
+  std::shared_ptr<Listener> listener;
+  int port;
+};
+}  // namespace ecuafast
@@ -0,0 +1,51 @@
+#include "tcp_transport.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+
+#include "connection.hpp"
+
+namespace ecuafast {
+
+TcpTransport::TcpTransport(std::string host) : host(std::move(host)) {}
+
+void TcpTransport::listen(int port, Reactor& reactor, AcceptHandler onAccept) {
+  auto server = std::make_unique<TcpServer>(reactor, port, std::move(onAccept));
+  server->start();
+
+  std::lock_guard<std::mutex> lock(serversMutex);
+  servers.push_back(std::move(server));
+}
+
+std::shared_ptr<MessageStream> TcpTransport::connect(EventLoop& loop,
+                                                     int port) {
+  sockaddr_in serverAddr{};
+  serverAddr.sin_family = AF_INET;
+  serverAddr.sin_port = htons(port);
+  if (inet_pton(AF_INET, host.c_str(), &serverAddr.sin_addr) <= 0) {
+    throw std::runtime_error("Invalid address");
+  }
+
+  int clientSocket =
+      socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (clientSocket < 0) {
+    throw std::runtime_error("Failed to create socket");
+  }
+
+  // Frames queued before the handshake completes go out on EPOLLOUT
+  if (::connect(clientSocket, reinterpret_cast<sockaddr*>(&serverAddr),
+                sizeof(serverAddr)) < 0 &&
+      errno != EINPROGRESS) {
+    ::close(clientSocket);
+    throw std::runtime_error("Connection failed");
+  }
+
+  return std::make_shared<Connection>(loop, clientSocket);
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "constants.hpp"
+#include "tcp_server.hpp"
+#include "transport.hpp"
+
+namespace ecuafast {
+// Framed TCP connections, for runs spread over several processes or hosts.
+// Connects are non-blocking; a refused one closes the returned stream.
+class TcpTransport : public Transport {
+ public:
+  explicit TcpTransport(std::string host = constants::DEFAULT_HOST);
+
+  void listen(int port, Reactor& reactor, AcceptHandler onAccept) override;
+  std::shared_ptr<MessageStream> connect(EventLoop& loop, int port) override;
+
+ private:
+  std::string host;
+  std::vector<std::unique_ptr<TcpServer>> servers;
+  std::mutex serversMutex;
+};
+}  // namespace ecuafast
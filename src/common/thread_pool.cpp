@@ -0,0 +1,131 @@
+#include "thread_pool.hpp"
+
+#include <iostream>
+
+namespace ecuafast {
+
+ThreadPool::ThreadPool(int threads, size_t queueCapacity, RejectPolicy policy)
+    : queueCapacity(queueCapacity > 0 ? queueCapacity : 1), policy(policy) {
+  if (threads < 1) {
+    threads = 1;
+  }
+
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([this]() { workerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() { shutdown(); }
+
+bool ThreadPool::submit(Task task) {
+  std::unique_lock<std::mutex> lock(tasksMutex);
+
+  if (tasks.size() >= queueCapacity && !stopping) {
+    switch (policy) {
+      case RejectPolicy::BLOCK:
+        notFull.wait(lock, [this]() {
+          return stopping || tasks.size() < queueCapacity;
+        });
+        break;
+      case RejectPolicy::REJECT:
+        rejected++;
+        return false;
+      case RejectPolicy::CALLER_RUNS:
+        lock.unlock();
+        task();
+        return true;
+    }
+  }
+
+  if (stopping) {
+    rejected++;
+    return false;
+  }
+
+  tasks.push_back(std::move(task));
+  lock.unlock();
+  notEmpty.notify_one();
+  return true;
+}
+
+bool ThreadPool::dispatch(Task task) {
+  std::unique_lock<std::mutex> lock(tasksMutex);
+
+  if (stopping) {
+    rejected++;
+    return false;
+  }
+
+  if (tasks.size() >= queueCapacity) {
+    switch (policy) {
+      case RejectPolicy::BLOCK:
+        parked.push_back(std::move(task));
+        return true;
+      case RejectPolicy::REJECT:
+        rejected++;
+        return false;
+      case RejectPolicy::CALLER_RUNS:
+        lock.unlock();
+        task();
+        return true;
+    }
+  }
+
+  tasks.push_back(std::move(task));
+  lock.unlock();
+  notEmpty.notify_one();
+  return true;
+}
+
+void ThreadPool::shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(tasksMutex);
+    if (stopping) {
+      return;
+    }
+    stopping = true;
+  }
+
+  notEmpty.notify_all();
+  notFull.notify_all();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::workerLoop() {
+  while (true) {
+    Task task;
+
+    {
+      std::unique_lock<std::mutex> lock(tasksMutex);
+      notEmpty.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+      // Drain whatever was accepted before shutdown
+      if (tasks.empty()) {
+        return;
+      }
+
+      task = std::move(tasks.front());
+      tasks.pop_front();
+
+      // A parked task takes the freed place, so the queue stays full
+      if (!parked.empty()) {
+        tasks.push_back(std::move(parked.front()));
+        parked.pop_front();
+      } else {
+        lock.unlock();
+        notFull.notify_one();
+      }
+    }
+
+    try {
+      task();
+    } catch (const std::exception& e) {
+      std::cerr << "Worker task failed: " << e.what() << "\n";
+    }
+  }
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ecuafast {
+// What submit() does when the task queue is already at capacity
+enum class RejectPolicy { BLOCK, REJECT, CALLER_RUNS };
+
+// Fixed-size executor with a bounded FIFO task queue, so that the number of
+// threads stays constant no matter how many connections arrive.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  ThreadPool(int threads, size_t queueCapacity, RejectPolicy policy);
+  ~ThreadPool();
+
+  // Returns false if the task was dropped by the REJECT policy
+  bool submit(Task task);
+  // For callers on an event loop thread, which must never wait: under BLOCK
+  // a task that finds the queue full is parked and joins the queue, in
+  // order, as workers make room. REJECT and CALLER_RUNS act as in submit().
+  bool dispatch(Task task);
+  void shutdown();
+
+  size_t rejectedCount() const { return rejected.load(); }
+
+ private:
+  std::vector<std::thread> workers;
+  std::deque<Task> tasks;
+  // Dispatched under BLOCK while tasks was full; non-empty only while it is
+  std::deque<Task> parked;
+  std::mutex tasksMutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  size_t queueCapacity;
+  RejectPolicy policy;
+  bool stopping = false;
+  std::atomic<size_t> rejected{0};
+
+  void workerLoop();
+};
+}  // namespace ecuafast
@@ -0,0 +1,131 @@
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+
+namespace ecuafast {
+
+TimerWheel::TimerWheel(Clock::duration tick)
+    : tick(tick), origin(Clock::now()) {}
+
+TimerWheel::TimerId TimerWheel::schedule(Clock::duration delay,
+                                         Callback callback) {
+  // Round up so a timer never fires early, and never into the current tick,
+  // which has already been processed
+  Clock::time_point when = Clock::now() + delay + tick - Clock::duration(1);
+  uint64_t expiry = ticksUntil(when);
+  expiry = std::max(expiry, currentTick + 1);
+
+  TimerId id = nextId++;
+  timers.emplace(id, Timer{expiry, std::move(callback)});
+  place(id, expiry);
+  return id;
+}
+
+bool TimerWheel::cancel(TimerId id) { return timers.erase(id) > 0; }
+
+TimerWheel::Clock::time_point TimerWheel::nextExpiry() const {
+  if (timers.empty()) {
+    return Clock::time_point::max();
+  }
+
+  auto at = [this](uint64_t tickNumber) {
+    return origin + tick * static_cast<Clock::rep>(tickNumber);
+  };
+
+  // Every timer on a level fires after every timer on the levels below, so
+  // the first live slot found going up is the earliest
+  for (int level = 0; level < LEVELS; ++level) {
+    int shift = SLOT_BITS * level;
+    uint64_t window = (currentTick >> (shift + SLOT_BITS))
+                      << (shift + SLOT_BITS);
+    for (uint64_t digit = ((currentTick >> shift) & SLOT_MASK) + 1;
+         digit <= SLOT_MASK; ++digit) {
+      for (TimerId id : wheel[level][digit]) {
+        if (timers.count(id)) {
+          return at(window | (digit << shift));
+        }
+      }
+    }
+  }
+
+  // Only the overflow list is left; it cascades when the top level wraps
+  int top = SLOT_BITS * LEVELS;
+  return at(((currentTick >> top) + 1) << top);
+}
+
+void TimerWheel::advance(Clock::time_point now,
+                         std::vector<Callback>& expired) {
+  uint64_t target = ticksUntil(now);
+
+  while (currentTick < target) {
+    if (timers.empty()) {
+      // Nothing can fire, so skip the idle stretch in one go. Slots may still
+      // hold ids of cancelled timers; those are ignored whenever visited.
+      currentTick = target;
+      break;
+    }
+    step(expired);
+  }
+}
+
+uint64_t TimerWheel::ticksUntil(Clock::time_point when) const {
+  if (when <= origin) {
+    return 0;
+  }
+  return static_cast<uint64_t>((when - origin) / tick);
+}
+
+void TimerWheel::place(TimerId id, uint64_t expiry) {
+  // A timer goes on the lowest level whose window still contains both now
+  // and its expiry; the slot is the expiry's digit at that level
+  for (int level = 0; level < LEVELS; ++level) {
+    int above = SLOT_BITS * (level + 1);
+    if ((expiry >> above) == (currentTick >> above)) {
+      size_t index = (expiry >> (SLOT_BITS * level)) & SLOT_MASK;
+      wheel[level][index].push_back(id);
+      return;
+    }
+  }
+  overflow.push_back(id);
+}
+
+void TimerWheel::cascade(Slot& slot) {
+  Slot pending;
+  pending.swap(slot);
+
+  for (TimerId id : pending) {
+    auto it = timers.find(id);
+    if (it != timers.end()) {
+      place(id, it->second.expiry);
+    }
+  }
+}
+
+void TimerWheel::step(std::vector<Callback>& expired) {
+  currentTick++;
+
+  // When a level's digit wraps, the slot now due on the level above is
+  // redistributed downwards; higher levels go first so their timers can
+  // trickle all the way to level 0 within this tick
+  if ((currentTick & ((uint64_t{1} << (SLOT_BITS * LEVELS)) - 1)) == 0) {
+    cascade(overflow);
+  }
+  for (int level = LEVELS - 1; level > 0; --level) {
+    int below = SLOT_BITS * level;
+    if ((currentTick & ((uint64_t{1} << below) - 1)) == 0) {
+      cascade(wheel[level][(currentTick >> below) & SLOT_MASK]);
+    }
+  }
+
+  Slot& due = wheel[0][currentTick & SLOT_MASK];
+  for (TimerId id : due) {
+    auto it = timers.find(id);
+    if (it != timers.end()) {
+      expired.push_back(std::move(it->second.callback));
+      timers.erase(it);
+    }
+  }
+  due.clear();
+}
+
+}  // namespace ecuafast
@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace ecuafast {
+// Hierarchical timing wheel: four levels of 64 slots, each level counting in
+// units 64 times coarser than the one below. Scheduling and cancelling are
+// O(1); a timer is moved down a level at most three times before it fires.
+// Timers further out than 64^4 ticks wait in an overflow list.
+//
+// Not synchronized: the owner guards it with its own mutex and runs the
+// callbacks handed back by advance() after letting go of that mutex.
+class TimerWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Callback = std::function<void()>;
+  using TimerId = uint64_t;
+
+  explicit TimerWheel(Clock::duration tick);
+
+  // Fires no earlier than `delay` from now, rounded up to a whole tick
+  TimerId schedule(Clock::duration delay, Callback callback);
+  // Returns false if the timer already fired or was cancelled
+  bool cancel(TimerId id);
+
+  bool empty() const { return timers.empty(); }
+  // When advance() next has work to do: the earliest expiry on the lowest
+  // occupied level, or the time its slot cascades down for higher levels.
+  // Never later than the next timer fires; time_point::max() when empty.
+  Clock::time_point nextExpiry() const;
+
+  // Moves the wheel up to `now`, appending the callbacks of every expired
+  // timer to `expired` in expiry order
+  void advance(Clock::time_point now, std::vector<Callback>& expired);
+
+ private:
+  static constexpr int LEVELS = 4;
+  static constexpr int SLOT_BITS = 6;
+  static constexpr uint64_t SLOT_MASK = (uint64_t{1} << SLOT_BITS) - 1;
+
+  struct Timer {
+    uint64_t expiry;
+    Callback callback;
+  };
+
+  using Slot = std::vector<TimerId>;
+
+  Clock::duration tick;
+  Clock::time_point origin;
+  uint64_t currentTick = 0;
+  TimerId nextId = 1;
+
+  // Slots hold ids only; a cancelled timer is dropped from `timers` and its
+  // id is skipped when the slot is next visited
+  std::unordered_map<TimerId, Timer> timers;
+  std::array<std::array<Slot, 1 << SLOT_BITS>, LEVELS> wheel;
+  Slot overflow;
+
+  uint64_t ticksUntil(Clock::time_point when) const;
+  void place(TimerId id, uint64_t expiry);
+  void cascade(Slot& slot);
+  void step(std::vector<Callback>& expired);
+};
+}  // namespace ecuafast
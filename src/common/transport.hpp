@@ -0,0 +1,50 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "event_loop.hpp"
+
+namespace ecuafast {
+// Bidirectional message link bound to one EventLoop. Handlers run on that
+// loop; send() and the close calls may come from any thread. Messages arrive
+// whole and in the order they were sent.
+class MessageStream : public std::enable_shared_from_this<MessageStream> {
+ public:
+  using MessageHandler =
+      std::function<void(const std::shared_ptr<MessageStream>&,
+                         const std::string& message)>;
+  using CloseHandler =
+      std::function<void(const std::shared_ptr<MessageStream>&)>;
+
+  virtual ~MessageStream() = default;
+
+  virtual void start(MessageHandler onMessage,
+                     CloseHandler onClose = nullptr) = 0;
+  virtual void send(const std::string& message) = 0;
+  virtual void closeAfterWrite() = 0;
+  virtual void close() = 0;
+
+  virtual EventLoop& loop() = 0;
+  virtual bool isClosed() const = 0;
+};
+
+// How ships, entities and the port manager reach each other. Servers listen
+// on a port number and clients connect to it; what a port means is up to
+// the transport.
+class Transport {
+ public:
+  using AcceptHandler =
+      std::function<void(const std::shared_ptr<MessageStream>&)>;
+
+  virtual ~Transport() = default;
+
+  // Accepted streams are spread over the reactor's loops round-robin and
+  // must be started by the handler
+  virtual void listen(int port, Reactor& reactor, AcceptHandler onAccept) = 0;
+  // The stream lives on `loop` and is returned unstarted. Throws if nothing
+  // listens on the port; a failure found later closes the stream instead.
+  virtual std::shared_ptr<MessageStream> connect(EventLoop& loop,
+                                                 int port) = 0;
+};
+}  // namespace ecuafast
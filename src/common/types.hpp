@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <nlohmann/json.hpp>
 #include <string>
 
@@ -33,10 +34,12 @@ struct ShipInfo {
   }
 };
 
+// The docked ship is stored inline so berths never touch the allocator
 struct PortSlot {
-  bool occupied;
-  ShipInfo* ship;
-  time_t arrivalTime;
-  time_t departureTime;
+  bool occupied = false;
+  ShipInfo ship{};
+  time_t arrivalTime = 0;
+  time_t departureTime = 0;
+  uint64_t unloadTimer = 0;  // pending TimerWheel id, 0 when not unloading
 };
 }  // namespace ecuafast
\ No newline at end of file
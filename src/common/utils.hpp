@@ -1,21 +1,53 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <random>
+#include <cmath>
+#include <vector>
+
+#include "random.hpp"
+#include "types.hpp"
 
 namespace ecuafast {
 namespace utils {
-inline double generateRandomProbability() {
-  static std::random_device rd;
-  static std::mt19937 gen(rd());
-  static std::uniform_real_distribution<> dis(0, 1);
-  return dis(gen);
+// Global time dilation applied to every simulated delay: 0.001 makes a
+// five-second unload take five milliseconds of real time
+inline std::atomic<double>& timeScale() {
+  static std::atomic<double> scale{1.0};
+  return scale;
+}
+
+inline void setTimeScale(double scale) {
+  timeScale() = scale > 0 ? scale : 1.0;
+}
+
+inline std::chrono::steady_clock::duration scaledSeconds(double seconds) {
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(seconds * timeScale().load()));
+}
+
+// Nearest-rank percentile of sorted values: the smallest one with at least
+// a fraction q of the sample at or below it, or 0 for no values
+inline double percentile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  double rank = std::ceil(q * sorted.size());
+  size_t index = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+  return sorted[std::min(index, sorted.size() - 1)];
 }
 
-inline int generateRandomDelay(int min, int max) {
-  static std::random_device rd;
-  static std::mt19937 gen(rd());
-  std::uniform_int_distribution<> dis(min, max);
-  return dis(gen);
+// Under a fixed seed, ship `id` comes out the same in every run
+inline ShipInfo generateRandomShip(int id) {
+  auto draw = [id]() { return random::uniform(random::Draw::SHIP, id); };
+  ShipInfo info;
+  info.type = static_cast<ShipType>(draw() > 0.5);
+  info.avgWeight = 50000 + draw() * 50000;
+  info.destination =
+      draw() > 0.5 ? "Ecuador" : (draw() > 0.5 ? "USA" : "Europe");
+  info.id = id;
+  info.needsInspection = false;
+  return info;
 }
 }  // namespace utils
 }  // namespace ecuafast
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace ecuafast {
+// Inspection verdicts for a batch of ships, one bit per ship in batch order;
+// a set bit means CHECK
+class VerdictBitmap {
+ public:
+  VerdictBitmap() = default;
+  explicit VerdictBitmap(size_t count)
+      : count(count), bits((count + 63) / 64, 0) {}
+
+  size_t size() const { return count; }
+  bool check(size_t index) const {
+    return (bits[index / 64] >> (index % 64)) & 1;
+  }
+  void set(size_t index, bool check) {
+    uint64_t mask = uint64_t{1} << (index % 64);
+    uint64_t& word = bits[index / 64];
+    word = check ? word | mask : word & ~mask;
+  }
+
+  std::vector<uint64_t>& words() { return bits; }
+  const std::vector<uint64_t>& words() const { return bits; }
+
+  // Bit i is eligible[i] && values[i] > threshold. The compare is a
+  // branch-free pass over contiguous doubles that the optimizer turns into
+  // SIMD compares; packing the results into words is a second pass.
+  static VerdictBitmap above(std::span<const double> values,
+                             std::span<const uint8_t> eligible,
+                             double threshold) {
+    return compare(values, eligible, threshold, std::greater<double>());
+  }
+  // Same with values[i] >= threshold
+  static VerdictBitmap atLeast(std::span<const double> values,
+                               std::span<const uint8_t> eligible,
+                               double threshold) {
+    return compare(values, eligible, threshold, std::greater_equal<double>());
+  }
+
+ private:
+  size_t count = 0;
+  std::vector<uint64_t> bits;
+
+  template <typename Compare>
+  static VerdictBitmap compare(std::span<const double> values,
+                               std::span<const uint8_t> eligible,
+                               double threshold, Compare matches) {
+    size_t count = std::min(values.size(), eligible.size());
+    std::vector<uint8_t> hits(count);
+    for (size_t i = 0; i < count; ++i) {
+      hits[i] = eligible[i] &
+                static_cast<uint8_t>(matches(values[i], threshold));
+    }
+
+    VerdictBitmap bitmap(count);
+    for (size_t i = 0; i < count; ++i) {
+      bitmap.bits[i / 64] |= static_cast<uint64_t>(hits[i]) << (i % 64);
+    }
+    return bitmap;
+  }
+};
+}  // namespace ecuafast
@@ -0,0 +1,350 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ship_json.hpp"
+#include "types.hpp"
+#include "verdict_bitmap.hpp"
+
+namespace ecuafast {
+enum class WireFormat { JSON, BINARY };
+
+namespace wire {
+// Version byte that opens every binary message. JSON messages always start
+// with '{', so the two formats can be told apart from the first byte.
+constexpr uint8_t BINARY_VERSION = 1;
+// Opens binary batch requests and replies instead
+constexpr uint8_t BINARY_BATCH_VERSION = 2;
+
+// Fixed little-endian layout, followed by destinationLength bytes
+struct BinaryRequest {
+  uint8_t version;
+  uint8_t type;
+  uint8_t needsInspection;
+  uint8_t destinationLength;
+  int32_t id;
+  uint64_t requestId;
+  double avgWeight;
+};
+
+// Followed by responseLength bytes
+struct BinaryReply {
+  uint8_t version;
+  uint8_t responseLength;
+  uint8_t reserved[6];
+  uint64_t requestId;
+};
+
+// Opens a batch request, followed by `count` ship records, and a batch reply,
+// followed by one little-endian verdict word per 64 ships
+struct BinaryBatchHeader {
+  uint8_t version;
+  uint8_t reserved[3];
+  uint32_t count;
+  uint64_t requestId;
+};
+
+// One ship of a batch, followed by destinationLength bytes
+struct BinaryShipRecord {
+  uint8_t type;
+  uint8_t needsInspection;
+  uint8_t destinationLength;
+  uint8_t reserved;
+  int32_t id;
+  double avgWeight;
+};
+
+static_assert(sizeof(BinaryRequest) == 24, "BinaryRequest layout changed");
+static_assert(sizeof(BinaryReply) == 16, "BinaryReply layout changed");
+static_assert(sizeof(BinaryBatchHeader) == 16,
+              "BinaryBatchHeader layout changed");
+static_assert(sizeof(BinaryShipRecord) == 16,
+              "BinaryShipRecord layout changed");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Binary wire format assumes a little-endian host");
+
+inline bool isBinary(const std::string& message) {
+  return !message.empty() &&
+         (static_cast<uint8_t>(message[0]) == BINARY_VERSION ||
+          static_cast<uint8_t>(message[0]) == BINARY_BATCH_VERSION);
+}
+
+// JSON batches carry their request ID under "batch", which sorts first
+inline bool isBatch(const std::string& message) {
+  return (!message.empty() &&
+          static_cast<uint8_t>(message[0]) == BINARY_BATCH_VERSION) ||
+         message.compare(0, 9, R"({"batch":)") == 0;
+}
+
+// Per-connection negotiation: the client's first frame is a hello naming
+// the format it wants, and the server acknowledges the one it will accept
+inline std::string encodeHello(WireFormat format) {
+  return format == WireFormat::BINARY ? R"({"wire":"binary"})"
+                                      : R"({"wire":"json"})";
+}
+
+inline bool decodeHello(const std::string& message, WireFormat& format) {
+  if (message == R"({"wire":"binary"})") {
+    format = WireFormat::BINARY;
+    return true;
+  }
+  if (message == R"({"wire":"json"})") {
+    format = WireFormat::JSON;
+    return true;
+  }
+  return false;
+}
+
+inline std::string encodeRequest(WireFormat format, uint64_t requestId,
+                                 const ShipInfo& ship) {
+  if (format == WireFormat::JSON) {
+    char buffer[ship_json::MAX_SIZE];
+    size_t length = ship_json::write(ship, buffer, sizeof(buffer), &requestId);
+    if (length == 0) {
+      throw std::runtime_error("Ship does not fit in a JSON request");
+    }
+    return std::string(buffer, length);
+  }
+
+  BinaryRequest header{};
+  header.version = BINARY_VERSION;
+  header.type = static_cast<uint8_t>(ship.type);
+  header.needsInspection = ship.needsInspection ? 1 : 0;
+  header.destinationLength =
+      static_cast<uint8_t>(std::min<size_t>(ship.destination.size(), 255));
+  header.id = ship.id;
+  header.requestId = requestId;
+  header.avgWeight = ship.avgWeight;
+
+  std::string message(sizeof(header) + header.destinationLength, '\0');
+  std::memcpy(message.data(), &header, sizeof(header));
+  std::memcpy(message.data() + sizeof(header), ship.destination.data(),
+              header.destinationLength);
+  return message;
+}
+
+// Accepts either format; throws on malformed input
+inline void decodeRequest(const std::string& message, uint64_t& requestId,
+                          ShipInfo& ship) {
+  if (!isBinary(message)) {
+    requestId = 0;
+    if (!ship_json::parse(message, ship, &requestId)) {
+      throw std::runtime_error("Malformed JSON request");
+    }
+    return;
+  }
+
+  BinaryRequest header;
+  if (message.size() < sizeof(header)) {
+    throw std::runtime_error("Truncated binary request");
+  }
+  std::memcpy(&header, message.data(), sizeof(header));
+  if (message.size() != sizeof(header) + header.destinationLength) {
+    throw std::runtime_error("Malformed binary request");
+  }
+
+  requestId = header.requestId;
+  ship.type = static_cast<ShipType>(header.type);
+  ship.avgWeight = header.avgWeight;
+  ship.destination.assign(message.data() + sizeof(header),
+                          header.destinationLength);
+  ship.id = header.id;
+  ship.needsInspection = header.needsInspection != 0;
+}
+
+inline std::string encodeReply(WireFormat format, uint64_t requestId,
+                               const std::string& response) {
+  if (format == WireFormat::JSON) {
+    return nlohmann::json{{"requestId", requestId}, {"response", response}}
+        .dump();
+  }
+
+  BinaryReply header{};
+  header.version = BINARY_VERSION;
+  header.responseLength =
+      static_cast<uint8_t>(std::min<size_t>(response.size(), 255));
+  header.requestId = requestId;
+
+  std::string message(sizeof(header) + header.responseLength, '\0');
+  std::memcpy(message.data(), &header, sizeof(header));
+  std::memcpy(message.data() + sizeof(header), response.data(),
+              header.responseLength);
+  return message;
+}
+
+inline void decodeReply(const std::string& message, uint64_t& requestId,
+                        std::string& response) {
+  if (!isBinary(message)) {
+    auto j = nlohmann::json::parse(message);
+    requestId = j["requestId"].get<uint64_t>();
+    response = j["response"].get<std::string>();
+    return;
+  }
+
+  BinaryReply header;
+  if (message.size() < sizeof(header)) {
+    throw std::runtime_error("Truncated binary reply");
+  }
+  std::memcpy(&header, message.data(), sizeof(header));
+  if (message.size() != sizeof(header) + header.responseLength) {
+    throw std::runtime_error("Malformed binary reply");
+  }
+
+  requestId = header.requestId;
+  response.assign(message.data() + sizeof(header), header.responseLength);
+}
+// Several ships under one request ID, answered with one VerdictBitmap
+inline std::string encodeBatchRequest(WireFormat format, uint64_t requestId,
+                                      std::span<const ShipInfo> ships) {
+  if (format == WireFormat::JSON) {
+    nlohmann::json list = nlohmann::json::array();
+    for (const ShipInfo& ship : ships) {
+      list.push_back(ship.to_json());
+    }
+    return nlohmann::json{{"batch", requestId}, {"ships", std::move(list)}}
+        .dump();
+  }
+
+  BinaryBatchHeader header{};
+  header.version = BINARY_BATCH_VERSION;
+  header.count = static_cast<uint32_t>(ships.size());
+  header.requestId = requestId;
+
+  std::string message(reinterpret_cast<const char*>(&header), sizeof(header));
+  message.reserve(sizeof(header) + ships.size() * 2 * sizeof(BinaryShipRecord));
+  for (const ShipInfo& ship : ships) {
+    BinaryShipRecord record{};
+    record.type = static_cast<uint8_t>(ship.type);
+    record.needsInspection = ship.needsInspection ? 1 : 0;
+    record.destinationLength =
+        static_cast<uint8_t>(std::min<size_t>(ship.destination.size(), 255));
+    record.id = ship.id;
+    record.avgWeight = ship.avgWeight;
+
+    message.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    message.append(ship.destination.data(), record.destinationLength);
+  }
+  return message;
+}
+
+// Accepts either format; throws on malformed input, which includes a batch
+// of no ships
+inline void decodeBatchRequest(const std::string& message,
+                               uint64_t& requestId,
+                               std::vector<ShipInfo>& ships) {
+  ships.clear();
+
+  if (message[0] != static_cast<char>(BINARY_BATCH_VERSION)) {
+    auto j = nlohmann::json::parse(message);
+    requestId = j["batch"].get<uint64_t>();
+    for (const auto& ship : j["ships"]) {
+      ships.push_back(ShipInfo::from_json(ship));
+    }
+    if (ships.empty()) {
+      throw std::runtime_error("Empty batch request");
+    }
+    return;
+  }
+
+  BinaryBatchHeader header;
+  if (message.size() < sizeof(header)) {
+    throw std::runtime_error("Truncated batch request");
+  }
+  std::memcpy(&header, message.data(), sizeof(header));
+  requestId = header.requestId;
+  if (header.count == 0) {
+    throw std::runtime_error("Empty batch request");
+  }
+
+  // The count comes off the wire: reserve no more than the bytes can hold
+  size_t offset = sizeof(header);
+  size_t fits = (message.size() - offset) / sizeof(BinaryShipRecord);
+  if (header.count > fits) {
+    throw std::runtime_error("Truncated batch request");
+  }
+  ships.reserve(header.count);
+  for (uint32_t i = 0; i < header.count; ++i) {
+    BinaryShipRecord record;
+    if (message.size() - offset < sizeof(record)) {
+      throw std::runtime_error("Truncated batch request");
+    }
+    std::memcpy(&record, message.data() + offset, sizeof(record));
+    offset += sizeof(record);
+    if (message.size() - offset < record.destinationLength) {
+      throw std::runtime_error("Truncated batch request");
+    }
+
+    ShipInfo& ship = ships.emplace_back();
+    ship.type = static_cast<ShipType>(record.type);
+    ship.avgWeight = record.avgWeight;
+    ship.destination.assign(message.data() + offset, record.destinationLength);
+    ship.id = record.id;
+    ship.needsInspection = record.needsInspection != 0;
+    offset += record.destinationLength;
+  }
+
+  if (offset != message.size()) {
+    throw std::runtime_error("Malformed batch request");
+  }
+}
+
+inline std::string encodeBatchReply(WireFormat format, uint64_t requestId,
+                                    const VerdictBitmap& verdicts) {
+  if (format == WireFormat::JSON) {
+    return nlohmann::json{{"batch", requestId},
+                          {"count", verdicts.size()},
+                          {"verdicts", verdicts.words()}}
+        .dump();
+  }
+
+  BinaryBatchHeader header{};
+  header.version = BINARY_BATCH_VERSION;
+  header.count = static_cast<uint32_t>(verdicts.size());
+  header.requestId = requestId;
+
+  const std::vector<uint64_t>& words = verdicts.words();
+  std::string message(sizeof(header) + words.size() * sizeof(uint64_t), '\0');
+  std::memcpy(message.data(), &header, sizeof(header));
+  std::memcpy(message.data() + sizeof(header), words.data(),
+              words.size() * sizeof(uint64_t));
+  return message;
+}
+
+inline void decodeBatchReply(const std::string& message, uint64_t& requestId,
+                             VerdictBitmap& verdicts) {
+  if (message[0] != static_cast<char>(BINARY_BATCH_VERSION)) {
+    auto j = nlohmann::json::parse(message);
+    requestId = j["batch"].get<uint64_t>();
+    size_t count = j["count"].get<size_t>();
+    auto words = j["verdicts"].get<std::vector<uint64_t>>();
+    if (words.size() != (count + 63) / 64) {
+      throw std::runtime_error("Malformed batch reply");
+    }
+    verdicts = VerdictBitmap(count);
+    verdicts.words() = std::move(words);
+    return;
+  }
+
+  BinaryBatchHeader header;
+  if (message.size() < sizeof(header)) {
+    throw std::runtime_error("Truncated batch reply");
+  }
+  std::memcpy(&header, message.data(), sizeof(header));
+
+  requestId = header.requestId;
+  size_t wordCount = (static_cast<size_t>(header.count) + 63) / 64;
+  if (message.size() != sizeof(header) + wordCount * sizeof(uint64_t)) {
+    throw std::runtime_error("Malformed batch reply");
+  }
+  verdicts = VerdictBitmap(header.count);
+  std::vector<uint64_t>& words = verdicts.words();
+  std::memcpy(words.data(), message.data() + sizeof(header),
+              words.size() * sizeof(uint64_t));
+}
+}  // namespace wire
+}  // namespace ecuafast
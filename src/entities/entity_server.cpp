@@ -0,0 +1,113 @@
+#include "entity_server.hpp"
+
+#include <iostream>
+
+namespace ecuafast {
+
+EntityServer::EntityServer(int port) : port(port) {}
+
+void EntityServer::start(Transport& transport, Reactor& reactor,
+                         ThreadPool& evaluationPool) {
+  this->evaluationPool = &evaluationPool;
+  transport.listen(port, reactor,
+                   [this](const std::shared_ptr<MessageStream>& connection) {
+                     connection->start(
+                         [this](const std::shared_ptr<MessageStream>& from,
+                                const std::string& message) {
+                           handleRequest(from, message);
+                         });
+                   });
+}
+
+void EntityServer::handleRequest(
+    const std::shared_ptr<MessageStream>& connection,
+    const std::string& message) {
+  // Both formats are understood, so any requested one is acknowledged
+  WireFormat requested;
+  if (wire::decodeHello(message, requested)) {
+    connection->send(wire::encodeHello(requested));
+    return;
+  }
+
+  if (wire::isBatch(message)) {
+    handleBatch(connection, message);
+    return;
+  }
+
+  // Reply in whatever format the request came in
+  WireFormat format =
+      wire::isBinary(message) ? WireFormat::BINARY : WireFormat::JSON;
+  uint64_t requestId;
+  ShipInfo ship;
+
+  try {
+    wire::decodeRequest(message, requestId, ship);
+  } catch (const std::exception& e) {
+    std::cerr << "Error processing request: " << e.what() << "\n";
+    return;
+  }
+
+  // Under the reject policy an overloaded server drops the request: the ship
+  // times out and retries while the connection stays up for the other ships
+  // sharing it. This runs on the loop thread, so it never waits for room.
+  evaluationPool->dispatch([this, connection, format, requestId, ship]() {
+    std::string response = evaluateShip(ship);
+
+    int response_time =
+        random::uniformInt(random::Draw::DELAY, ship.id, 1, 5, port);
+
+    std::string replyStr = wire::encodeReply(format, requestId, response);
+
+    // Simulate random response time without blocking the loop
+    connection->loop().runAfter(
+        utils::scaledSeconds(response_time),
+        [connection, replyStr]() { connection->send(replyStr); });
+  });
+}
+
+void EntityServer::handleBatch(
+    const std::shared_ptr<MessageStream>& connection,
+    const std::string& message) {
+  WireFormat format =
+      wire::isBinary(message) ? WireFormat::BINARY : WireFormat::JSON;
+  uint64_t requestId;
+  std::vector<ShipInfo> ships;
+
+  try {
+    wire::decodeBatchRequest(message, requestId, ships);
+  } catch (const std::exception& e) {
+    std::cerr << "Error processing batch: " << e.what() << "\n";
+    return;
+  }
+  if (ships.empty()) {
+    return;  // nothing to answer, and no ship to key the delay by
+  }
+
+  // One evaluation and one simulated response time for the whole batch,
+  // dispatched like a single request
+  evaluationPool->dispatch(
+      [this, connection, format, requestId, ships = std::move(ships)]() {
+        VerdictBitmap verdicts = evaluateShips(ships);
+
+        // Keyed by the first ship, the batch's delay is replayable too
+        int response_time = random::uniformInt(
+            random::Draw::DELAY, ships.front().id, 1, 5, port);
+
+        std::string replyStr =
+            wire::encodeBatchReply(format, requestId, verdicts);
+
+        connection->loop().runAfter(
+            utils::scaledSeconds(response_time),
+            [connection, replyStr]() { connection->send(replyStr); });
+      });
+}
+
+VerdictBitmap EntityServer::evaluateShips(std::span<const ShipInfo> ships) {
+  VerdictBitmap verdicts(ships.size());
+  for (size_t i = 0; i < ships.size(); ++i) {
+    verdicts.set(i, evaluateShip(ships[i]) == constants::RESPONSE_CHECK);
+  }
+  return verdicts;
+}
+
+}  // namespace ecuafast
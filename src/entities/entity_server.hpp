@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <string>
+
+#include "../common/constants.hpp"
+#include "../common/event_loop.hpp"
+#include "../common/thread_pool.hpp"
+#include "../common/transport.hpp"
+#include "../common/types.hpp"
+#include "../common/utils.hpp"
+#include "../common/verdict_bitmap.hpp"
+#include "../common/wire_format.hpp"
+
+namespace ecuafast {
+// Shared networking for the control entities: requests arrive on a Reactor,
+// are evaluated on a bounded ThreadPool and answered from the loop after a
+// simulated delay, without holding a thread per connection.
+class EntityServer {
+ public:
+  explicit EntityServer(int port);
+  virtual ~EntityServer() = default;
+
+  void start(Transport& transport, Reactor& reactor,
+             ThreadPool& evaluationPool);
+  virtual std::string evaluateShip(const ShipInfo& ship) = 0;
+  // Verdicts for a whole batch. This default asks evaluateShip() one ship
+  // at a time; entities override it to take their statistics lock once.
+  virtual VerdictBitmap evaluateShips(std::span<const ShipInfo> ships);
+
+  int getPort() const { return port; }
+
+ protected:
+  int port;
+
+ private:
+  ThreadPool* evaluationPool = nullptr;
+
+  void handleRequest(const std::shared_ptr<MessageStream>& connection,
+                     const std::string& message);
+  void handleBatch(const std::shared_ptr<MessageStream>& connection,
+                   const std::string& message);
+};
+}  // namespace ecuafast
@@ -1,30 +1,10 @@
 #include "senae_server.hpp"
 
-#include <algorithm>
-#include <iostream>
-#include <numeric>
-#include <thread>
-
 namespace ecuafast {
 
-SENAEServer::SENAEServer(int port) : port(port) {}
-
-void SENAEServer::start() {
-  int serverSocket = SocketWrapper::createServerSocket(port);
-
-  while (true) {
-    sockaddr_in clientAddr{};
-    socklen_t clientLen = sizeof(clientAddr);
-    int clientSocket =
-        accept(serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
-
-    if (clientSocket >= 0) {
-      std::thread([this, clientSocket]() {
-        this->handleClient(clientSocket);
-      }).detach();
-    }
-  }
-}
+SENAEServer::SENAEServer(int port, QuantileMode quantileMode)
+    : EntityServer(port),
+      weightQuartile(makeQuantileEstimator(quantileMode, 0.75)) {}
 
 std::string SENAEServer::evaluateShip(const ShipInfo& ship) {
   std::lock_guard<std::mutex> lock(weightsMutex);
@@ -32,50 +12,39 @@ std::string SENAEServer::evaluateShip(const ShipInfo& ship) {
   if (ship.type == ShipType::PANAMAX &&
       ship.avgWeight >= calculateThirdQuartile() &&
       (ship.destination == "Europe" || ship.destination == "USA")) {
-    allWeights.push_back(ship.avgWeight);
+    weightQuartile->insert(ship.avgWeight);
     return constants::RESPONSE_CHECK;
   }
 
-  allWeights.push_back(ship.avgWeight);
+  weightQuartile->insert(ship.avgWeight);
   return constants::RESPONSE_PASS;
 }
 
-double SENAEServer::calculateThirdQuartile() {
-  if (allWeights.empty()) {
-    return 0.0;
+VerdictBitmap SENAEServer::evaluateShips(std::span<const ShipInfo> ships) {
+  std::vector<double> weights(ships.size());
+  std::vector<uint8_t> eligible(ships.size());
+  for (size_t i = 0; i < ships.size(); ++i) {
+    weights[i] = ships[i].avgWeight;
+    eligible[i] =
+        ships[i].type == ShipType::PANAMAX &&
+        (ships[i].destination == "Europe" || ships[i].destination == "USA");
   }
 
-  std::vector<double> sortedWeights = allWeights;
-  std::sort(sortedWeights.begin(), sortedWeights.end());
-
-  size_t idx = (sortedWeights.size() * 3) / 4;
-  return sortedWeights[idx];
-}
-
-void SENAEServer::handleClient(int clientSocket) {
-  char buffer[1024] = {0};
-  ssize_t bytesRead = read(clientSocket, buffer, sizeof(buffer));
-
-  if (bytesRead > 0) {
-    try {
-      auto j = nlohmann::json::parse(buffer);
-      ShipInfo ship = ShipInfo::from_json(j);
-      std::string response = evaluateShip(ship);
-
-      int response_time = utils::generateRandomDelay(1, 5);
-
-      // Simulate random response time
-      std::this_thread::sleep_for(std::chrono::seconds(response_time));
-
-      // std::cout << "Ship " << ship.id << " got " << response << " after "
-      //           << response_time << " seconds\n";
+  // One lock and one quartile for the batch; its weights count from the
+  // next request on
+  std::lock_guard<std::mutex> lock(weightsMutex);
 
-      send(clientSocket, response.c_str(), response.length(), 0);
-    } catch (const std::exception& e) {
-      std::cerr << "Error processing request: " << e.what() << "\n";
-    }
+  VerdictBitmap verdicts =
+      VerdictBitmap::atLeast(weights, eligible, calculateThirdQuartile());
+  for (double weight : weights) {
+    weightQuartile->insert(weight);
   }
 
-  close(clientSocket);
+  return verdicts;
+}
+
+double SENAEServer::calculateThirdQuartile() {
+  // O(log n) in exact mode, O(1) in approximate mode
+  return weightQuartile->value();
 }
 }  // namespace ecuafast
\ No newline at end of file
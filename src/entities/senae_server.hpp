@@ -1,25 +1,21 @@
 #pragma once
+#include <memory>
 #include <mutex>
-#include <vector>
 
-#include "../common/constants.hpp"
-#include "../common/socket_wrapper.hpp"
-#include "../common/types.hpp"
-#include "../common/utils.hpp"
+#include "../common/quantile.hpp"
+#include "entity_server.hpp"
 
 namespace ecuafast {
-class SENAEServer {
+class SENAEServer : public EntityServer {
  public:
-  SENAEServer(int port);
-  void start();
-  std::string evaluateShip(const ShipInfo& ship);
+  SENAEServer(int port, QuantileMode quantileMode = QuantileMode::EXACT);
+  std::string evaluateShip(const ShipInfo& ship) override;
+  VerdictBitmap evaluateShips(std::span<const ShipInfo> ships) override;
 
  private:
-  std::vector<double> allWeights;
+  std::unique_ptr<QuantileEstimator> weightQuartile;
   std::mutex weightsMutex;
-  int port;
 
   double calculateThirdQuartile();
-  void handleClient(int clientSocket);
 };
 }  // namespace ecuafast
\ No newline at end of file
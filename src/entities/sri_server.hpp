@@ -1,25 +1,17 @@
 #pragma once
-#include <mutex>
-#include <vector>
-
-#include "../common/constants.hpp"
-#include "../common/socket_wrapper.hpp"
-#include "../common/types.hpp"
-#include "../common/utils.hpp"
+#include "../common/rolling_average.hpp"
+#include "entity_server.hpp"
 
 namespace ecuafast {
-class SRIServer {
+class SRIServer : public EntityServer {
  public:
-  SRIServer(int port);
-  void start();
-  std::string evaluateShip(const ShipInfo& ship);
+  SRIServer(int port, size_t windowSize = 20);
+  std::string evaluateShip(const ShipInfo& ship) override;
+  VerdictBitmap evaluateShips(std::span<const ShipInfo> ships) override;
 
  private:
-  std::vector<double> lastTwentyWeights;
-  std::mutex weightsMutex;
-  int port;
+  RollingAverage recentWeights;
 
   double calculateAverage();
-  void handleClient(int clientSocket);
 };
 }  // namespace ecuafast
\ No newline at end of file
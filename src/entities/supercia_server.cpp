@@ -1,64 +1,29 @@
 #include "supercia_server.hpp"
 
-#include <iostream>
-#include <thread>
-
 namespace ecuafast {
 
-SuperCIAServer::SuperCIAServer(int port) : port(port) {}
-
-void SuperCIAServer::start() {
-  int serverSocket = SocketWrapper::createServerSocket(port);
-
-  while (true) {
-    sockaddr_in clientAddr{};
-    socklen_t clientLen = sizeof(clientAddr);
-    int clientSocket =
-        accept(serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
-
-    if (clientSocket >= 0) {
-      std::thread([this, clientSocket]() {
-        this->handleClient(clientSocket);
-      }).detach();
-    }
-  }
-}
+SuperCIAServer::SuperCIAServer(int port) : EntityServer(port) {}
 
 std::string SuperCIAServer::evaluateShip(const ShipInfo& ship) {
   double checkProbability = (ship.type == ShipType::CONVENTIONAL) ? 0.3 : 0.5;
 
-  if (utils::generateRandomProbability() < checkProbability) {
+  if (random::uniform(random::Draw::VERDICT, ship.id) < checkProbability) {
     return constants::RESPONSE_CHECK;
   }
 
   return constants::RESPONSE_PASS;
 }
 
-void SuperCIAServer::handleClient(int clientSocket) {
-  char buffer[1024] = {0};
-  ssize_t bytesRead = read(clientSocket, buffer, sizeof(buffer));
-
-  if (bytesRead > 0) {
-    try {
-      auto j = nlohmann::json::parse(buffer);
-      ShipInfo ship = ShipInfo::from_json(j);
-      std::string response = evaluateShip(ship);
-
-      int response_time = utils::generateRandomDelay(1, 5);
-
-      // Simulate random response time
-      std::this_thread::sleep_for(std::chrono::seconds(response_time));
-
-      // std::cout << "Ship " << ship.id << " got " << response << " after "
-      //           << response_time << " seconds\n";
-
-      send(clientSocket, response.c_str(), response.length(), 0);
-    } catch (const std::exception& e) {
-      std::cerr << "Error processing request: " << e.what() << "\n";
-    }
+VerdictBitmap SuperCIAServer::evaluateShips(std::span<const ShipInfo> ships) {
+  // No statistics to lock; every ship still gets its own draw
+  VerdictBitmap verdicts(ships.size());
+  for (size_t i = 0; i < ships.size(); ++i) {
+    double checkProbability =
+        (ships[i].type == ShipType::CONVENTIONAL) ? 0.3 : 0.5;
+    verdicts.set(i, random::uniform(random::Draw::VERDICT, ships[i].id) <
+                        checkProbability);
   }
-
-  close(clientSocket);
+  return verdicts;
 }
 
 }  // namespace ecuafast
\ No newline at end of file
@@ -1,18 +1,11 @@
 #pragma once
-#include "../common/constants.hpp"
-#include "../common/socket_wrapper.hpp"
-#include "../common/types.hpp"
-#include "../common/utils.hpp"
+#include "entity_server.hpp"
 
 namespace ecuafast {
-class SuperCIAServer {
+class SuperCIAServer : public EntityServer {
  public:
   SuperCIAServer(int port);
-  void start();
-  std::string evaluateShip(const ShipInfo& ship);
-
- private:
-  int port;
-  void handleClient(int clientSocket);
+  std::string evaluateShip(const ShipInfo& ship) override;
+  VerdictBitmap evaluateShips(std::span<const ShipInfo> ships) override;
 };
 }  // namespace ecuafast
\ No newline at end of file
@@ -1,10 +1,32 @@
 #include <getopt.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <latch>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <thread>
 #include <vector>
 
+#include "common/arrival_process.hpp"
+#include "common/arrival_trace.hpp"
 #include "common/constants.hpp"
+#include "common/event_log.hpp"
+#include "common/event_loop.hpp"
+#include "common/latency_recorder.hpp"
+#include "common/local_transport.hpp"
+#include "common/random.hpp"
+#include "common/shm_transport.hpp"
+#include "common/task.hpp"
+#include "common/tcp_transport.hpp"
+#include "common/thread_pool.hpp"
 #include "common/types.hpp"
 #include "common/utils.hpp"
 #include "entities/senae_server.hpp"
@@ -12,6 +34,225 @@
 #include "entities/supercia_server.hpp"
 #include "port/port_manager.hpp"
 #include "ship/ship_client.hpp"
+#include "sim/simulation.hpp"
+#include "sim/sweep.hpp"
+
+using ArrivalSource = std::function<bool(ecuafast::Arrival&)>;
+
+// Ships from a trace file, or generated open-loop at a target rate; empty
+// when ships are to be generated all at once
+struct Arrivals {
+  std::string tracePath;
+  std::optional<ecuafast::ArrivalPattern> pattern;
+  double rate = 1.0;
+  double burstSeconds = 10.0;
+
+  bool streamed() const { return !tracePath.empty() || pattern; }
+
+  // Throws std::runtime_error if the trace cannot be opened
+  ArrivalSource open(int shipCount) const {
+    if (!tracePath.empty()) {
+      auto trace = std::make_shared<ecuafast::ArrivalTrace>(tracePath);
+      return [trace](ecuafast::Arrival& arrival) {
+        return trace->next(arrival);
+      };
+    }
+
+    // Gaps get their own stream, clear of the thread streams
+    uint64_t seed = ecuafast::Random(ecuafast::random::seed(), 0)();
+    auto generator = std::make_shared<ecuafast::ArrivalGenerator>(
+        *pattern, rate, shipCount, burstSeconds, seed);
+    return [generator](ecuafast::Arrival& arrival) {
+      return generator->next(arrival);
+    };
+  }
+};
+
+int runSimulation(const ecuafast::SimulationConfig& config, int shipCount,
+                  const Arrivals& arrivals) {
+  auto wallStart = std::chrono::steady_clock::now();
+
+  ecuafast::SimulationReport report;
+  try {
+    ecuafast::Simulation simulation(config, std::cout);
+    if (arrivals.streamed()) {
+      simulation.streamArrivals(arrivals.open(shipCount));
+    } else {
+      for (int i = 0; i < shipCount; ++i) {
+        simulation.addArrival(0.0, ecuafast::utils::generateRandomShip(i));
+      }
+    }
+    report = simulation.run();
+  } catch (const std::runtime_error& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+  shipCount = report.ships.size();
+
+  auto wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - wallStart);
+
+  int inspected = 0, unloaded = 0, rejected = 0, damaged = 0;
+  for (const auto& ship : report.ships) {
+    inspected += ship.needsInspection;
+    unloaded += ship.departure >= 0;
+    rejected += ship.rejected;
+    damaged += ship.damaged;
+  }
+
+  std::cout << "Simulation completed: " << shipCount << " ships in "
+            << report.makespan << " simulated seconds (" << wallTime.count()
+            << " ms wall, " << report.events << " events)\n"
+            << "  inspected " << inspected << ", unloaded " << unloaded
+            << ", rejected " << rejected << ", damaged " << damaged << "\n";
+  return 0;
+}
+
+int runSweep(const ecuafast::SimulationConfig& base, const std::string& spec,
+             int shipCount, int replicas) {
+  ecuafast::SweepGrid grid;
+  try {
+    grid = ecuafast::SweepGrid::parse(spec, base);
+  } catch (const std::invalid_argument& e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    return 1;
+  }
+
+  auto wallStart = std::chrono::steady_clock::now();
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<ecuafast::SweepRow> rows =
+      ecuafast::runSweep(base, grid, shipCount, replicas, threads,
+                         ecuafast::random::seed());
+  auto wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - wallStart);
+
+  ecuafast::printSweep(std::cout, rows);
+  std::cout << "Sweep completed: " << rows.size() << " points x "
+            << std::max(replicas, 1) << " runs of " << shipCount
+            << " ships on " << threads << " threads in " << wallTime.count()
+            << " ms\n";
+  return 0;
+}
+
+// Sails ships one after another until none are left. Several lanes run on
+// each client loop, so the number of lanes is the number of ships in flight.
+ecuafast::Task<> sailShips(const std::vector<ecuafast::ShipInfo>& ships,
+                           std::atomic<size_t>& nextShip, int timeout,
+                           const ecuafast::RetryPolicy& policy,
+                           ecuafast::EntityChannels& entities,
+                           ecuafast::Transport& transport,
+                           ecuafast::EventLoop& loop, std::latch& finished) {
+  size_t index;
+  while ((index = nextShip.fetch_add(1)) < ships.size()) {
+    ecuafast::ShipClient ship(ships[index], timeout, policy, entities,
+                              transport, loop);
+    co_await ship.start();
+  }
+  finished.count_down();
+}
+
+// Sails one ship that was due at `due` and counts it out when it is done
+ecuafast::Task<> sailArrival(ecuafast::ShipInfo info,
+                             ecuafast::LatencyRecorder::Clock::time_point due,
+                             int timeout, const ecuafast::RetryPolicy& policy,
+                             ecuafast::EntityChannels& entities,
+                             ecuafast::Transport& transport,
+                             ecuafast::EventLoop& loop,
+                             ecuafast::LatencyRecorder& latencies,
+                             std::shared_ptr<std::atomic<size_t>> inFlight) {
+  auto started = ecuafast::LatencyRecorder::Clock::now();
+  {
+    ecuafast::ShipClient ship(info, timeout, policy, entities, transport,
+                              loop);
+    co_await ship.start();
+  }
+  latencies.record(due, started, ecuafast::LatencyRecorder::Clock::now());
+
+  // Shared, so the counter outlives the waiter that the decrement releases
+  inFlight->fetch_sub(1);
+  inFlight->notify_all();
+}
+
+// Releases each ship at its arrival time, scaled like every other delay,
+// whether or not earlier ships are done. Past `limit` ships in flight the
+// schedule waits for one to finish, so it runs late rather than out of
+// descriptors; ships it delays still count from when they were due.
+void sailArrivals(const ArrivalSource& source, size_t limit, int timeout,
+                  const ecuafast::RetryPolicy& policy,
+                  ecuafast::EntityChannels& entities,
+                  ecuafast::Transport& transport, ecuafast::Reactor& reactor,
+                  ecuafast::LatencyRecorder& latencies) {
+  auto origin = ecuafast::LatencyRecorder::Clock::now();
+  auto inFlight = std::make_shared<std::atomic<size_t>>(0);
+
+  // A bad entry stops the schedule, but ships already sailing still use
+  // the caller's channels; they are waited for before the error goes up
+  std::exception_ptr error;
+  ecuafast::Arrival arrival;
+  while (true) {
+    try {
+      if (!source(arrival)) {
+        break;
+      }
+    } catch (...) {
+      error = std::current_exception();
+      break;
+    }
+
+    auto due = origin + ecuafast::utils::scaledSeconds(arrival.time);
+    std::this_thread::sleep_until(due);
+
+    size_t current;
+    while ((current = inFlight->load()) >= limit) {
+      inFlight->wait(current);
+    }
+    inFlight->fetch_add(1);
+
+    ecuafast::EventLoop* loop = &reactor.nextLoop();
+    loop->post([&, loop, due, inFlight, ship = arrival.ship]() {
+      ecuafast::spawn(sailArrival(ship, due, timeout, policy, entities,
+                                  transport, *loop, latencies, inFlight));
+    });
+  }
+
+  size_t current;
+  while ((current = inFlight->load()) != 0) {
+    inFlight->wait(current);
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// Over TCP, each ship in flight holds a socket on both ends of the port
+// manager connection, all inside this process
+size_t defaultShipsInFlight() {
+  rlimit limit{};
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+    return 1000;
+  }
+  if (limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  const rlim_t reserved = 256;
+  if (limit.rlim_cur == RLIM_INFINITY) {
+    return 100000;
+  }
+  return limit.rlim_cur > 2 * reserved ? (limit.rlim_cur - reserved) / 2 : 1;
+}
+
+std::unique_ptr<ecuafast::Transport> makeTransport(const std::string& name) {
+  if (name == "local") {
+    return std::make_unique<ecuafast::LocalTransport>();
+  }
+  if (name == "shm") {
+    return std::make_unique<ecuafast::ShmTransport>();
+  }
+  return std::make_unique<ecuafast::TcpTransport>();
+}
 
 void printUsage() {
   std::cout << "Usage: ecuafast [options]\n"
@@ -20,7 +261,51 @@ void printUsage() {
             << "  -y SECONDS   Base unloading time\n"
             << "  -z COUNT     Number of ships to simulate\n"
             << "  -n COUNT     Maximum number of port slots\n"
-            << "  -p PROB      Probability of ship damage (0.0-1.0)\n";
+            << "  -p PROB      Probability of ship damage (0.0-1.0)\n"
+            << "  -e COUNT     Event loop threads for control entities\n"
+            << "  -w COUNT     Port manager worker threads\n"
+            << "  -b DEPTH     Maximum queued tasks per worker pool\n"
+            << "  -r POLICY    Full queue policy: block, reject or caller\n"
+            << "  -q MODE      SENAE quartile engine: exact or p2\n"
+            << "  -a COUNT     SRI rolling average window size\n"
+            << "  -c COUNT     Shared connections from ships to each entity\n"
+            << "  -f FORMAT    Entity wire format: binary or json\n"
+            << "  -u COUNT     Coalesce up to COUNT entity requests into one\n"
+            << "               batch (1: off)\n"
+            << "  -d           Discrete-event simulation on a virtual clock\n"
+            << "  -t SCALE     Time scale for simulated delays (e.g. 0.001)\n"
+            << "  -m COUNT     Maximum ships in flight (default: as many as\n"
+            << "               file descriptors allow)\n"
+            << "  -l SECONDS   Inspection deadline per ship; unanswered\n"
+            << "               entities then count as CHECK (0: none)\n"
+            << "  -k SECONDS   Base retry backoff, doubled per retry (0: off)\n"
+            << "  -g QUANTILE  Hedge requests slower than this reply latency\n"
+            << "               quantile, e.g. 0.95 (0: off)\n"
+            << "  -s TRANSPORT Between ships, entities and port manager: tcp,\n"
+            << "               shm (shared memory, same host) or local\n"
+            << "               (in-process, no sockets)\n"
+            << "  -o ROLE      Run everything (all), only the entities and\n"
+            << "               port manager (servers) or only the ships\n"
+            << "  --seed N     Draw ships, verdicts, delays and damage from\n"
+            << "               substreams of N, so runs can be replayed\n"
+            << "  --sweep GRID Simulate every combination of a parameter grid\n"
+            << "               in parallel and print one row per point,\n"
+            << "               e.g. \"n=5,10;y=5,10;p=0.1,0.2;x=4,8\"\n"
+            << "  --replicas N Simulations per sweep point (default 1)\n"
+            << "  --trace FILE Sail the ships recorded in FILE (CSV or\n"
+            << "               binary) at their arrival times, instead of\n"
+            << "               -z random ships all at once\n"
+            << "  --arrivals PATTERN\n"
+            << "               Sail -z ships open-loop at --rate: constant,\n"
+            << "               poisson or mmpp (bursts), and report\n"
+            << "               latencies counted from each ship's due time\n"
+            << "  --rate R     Ships per simulated second (default 1)\n"
+            << "  --burst SECONDS\n"
+            << "               Mean length of mmpp busy and quiet spells\n"
+            << "               (default 10)\n"
+            << "  --event-log FILE\n"
+            << "               Write each ship's events, sorted by time, to\n"
+            << "               FILE as CSV\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -29,9 +314,50 @@ int main(int argc, char* argv[]) {
   int shipCount = 10;
   int maxSlots = 5;
   double damageProb = 0.2;
+  int loopThreads = 2;
+  int workerThreads = 64;
+  size_t queueDepth = 1024;
+  ecuafast::RejectPolicy rejectPolicy = ecuafast::RejectPolicy::BLOCK;
+  ecuafast::QuantileMode quantileMode = ecuafast::QuantileMode::EXACT;
+  size_t averageWindow = 20;
+  int entityConnections = 4;
+  ecuafast::WireFormat wireFormat = ecuafast::WireFormat::BINARY;
+  size_t batchSize = 1;
+  bool simulate = false;
+  size_t shipsInFlight = 0;
+  ecuafast::RetryPolicy retryPolicy;
+  std::string transportName = "tcp";
+  std::string role = "all";
+  std::string eventLogPath;
+  std::string sweepGrid;
+  int replicas = 1;
+  Arrivals arrivals;
 
+  enum {
+    OPTION_SEED = 256,
+    OPTION_EVENT_LOG,
+    OPTION_SWEEP,
+    OPTION_REPLICAS,
+    OPTION_TRACE,
+    OPTION_ARRIVALS,
+    OPTION_RATE,
+    OPTION_BURST
+  };
+  const option longOptions[] = {
+      {"seed", required_argument, nullptr, OPTION_SEED},
+      {"event-log", required_argument, nullptr, OPTION_EVENT_LOG},
+      {"sweep", required_argument, nullptr, OPTION_SWEEP},
+      {"replicas", required_argument, nullptr, OPTION_REPLICAS},
+      {"trace", required_argument, nullptr, OPTION_TRACE},
+      {"arrivals", required_argument, nullptr, OPTION_ARRIVALS},
+      {"rate", required_argument, nullptr, OPTION_RATE},
+      {"burst", required_argument, nullptr, OPTION_BURST},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+  const char* options = "x:y:z:n:p:e:w:b:r:q:a:c:f:u:dt:m:l:k:g:s:o:h";
   int opt;
-  while ((opt = getopt(argc, argv, "x:y:z:n:p:h")) != -1) {
+  while ((opt = getopt_long(argc, argv, options, longOptions, nullptr)) !=
+         -1) {
     switch (opt) {
       case 'x':
         timeout = std::atoi(optarg);
@@ -48,6 +374,122 @@ int main(int argc, char* argv[]) {
       case 'p':
         damageProb = std::atof(optarg);
         break;
+      case 'e':
+        loopThreads = std::atoi(optarg);
+        break;
+      case 'w':
+        workerThreads = std::atoi(optarg);
+        break;
+      case 'b':
+        queueDepth = std::strtoul(optarg, nullptr, 10);
+        break;
+      case 'r':
+        if (std::string(optarg) == "block") {
+          rejectPolicy = ecuafast::RejectPolicy::BLOCK;
+        } else if (std::string(optarg) == "reject") {
+          rejectPolicy = ecuafast::RejectPolicy::REJECT;
+        } else if (std::string(optarg) == "caller") {
+          rejectPolicy = ecuafast::RejectPolicy::CALLER_RUNS;
+        } else {
+          printUsage();
+          return 1;
+        }
+        break;
+      case 'q':
+        if (std::string(optarg) == "exact") {
+          quantileMode = ecuafast::QuantileMode::EXACT;
+        } else if (std::string(optarg) == "p2") {
+          quantileMode = ecuafast::QuantileMode::APPROXIMATE;
+        } else {
+          printUsage();
+          return 1;
+        }
+        break;
+      case 'a':
+        averageWindow = std::strtoul(optarg, nullptr, 10);
+        break;
+      case 'c':
+        entityConnections = std::atoi(optarg);
+        break;
+      case 'f':
+        if (std::string(optarg) == "binary") {
+          wireFormat = ecuafast::WireFormat::BINARY;
+        } else if (std::string(optarg) == "json") {
+          wireFormat = ecuafast::WireFormat::JSON;
+        } else {
+          printUsage();
+          return 1;
+        }
+        break;
+      case 'u':
+        batchSize = std::strtoul(optarg, nullptr, 10);
+        break;
+      case 'd':
+        simulate = true;
+        break;
+      case 't':
+        ecuafast::utils::setTimeScale(std::atof(optarg));
+        break;
+      case 'm':
+        shipsInFlight = std::strtoul(optarg, nullptr, 10);
+        break;
+      case 'l':
+        retryPolicy.deadline = std::atof(optarg);
+        break;
+      case 'k':
+        retryPolicy.backoffBase = std::atof(optarg);
+        break;
+      case 'g':
+        retryPolicy.hedgeQuantile = std::atof(optarg);
+        break;
+      case 's':
+        transportName = optarg;
+        if (transportName != "tcp" && transportName != "shm" &&
+            transportName != "local") {
+          printUsage();
+          return 1;
+        }
+        break;
+      case 'o':
+        role = optarg;
+        if (role != "all" && role != "servers" && role != "ships") {
+          printUsage();
+          return 1;
+        }
+        break;
+      case OPTION_SEED:
+        ecuafast::random::setSeed(std::strtoull(optarg, nullptr, 10));
+        break;
+      case OPTION_EVENT_LOG:
+        eventLogPath = optarg;
+        break;
+      case OPTION_SWEEP:
+        sweepGrid = optarg;
+        break;
+      case OPTION_REPLICAS:
+        replicas = std::atoi(optarg);
+        break;
+      case OPTION_TRACE:
+        arrivals.tracePath = optarg;
+        break;
+      case OPTION_ARRIVALS:
+        if (std::string(optarg) == "constant") {
+          arrivals.pattern = ecuafast::ArrivalPattern::CONSTANT;
+        } else if (std::string(optarg) == "poisson") {
+          arrivals.pattern = ecuafast::ArrivalPattern::POISSON;
+        } else if (std::string(optarg) == "mmpp") {
+          arrivals.pattern = ecuafast::ArrivalPattern::MMPP;
+        } else {
+          printUsage();
+          return 1;
+        }
+        break;
+      case OPTION_RATE:
+        arrivals.rate = std::atof(optarg);
+        break;
+      case OPTION_BURST:
+        arrivals.burstSeconds = std::atof(optarg);
+        break;
       case 'h':
         printUsage();
         return 0;
@@ -57,47 +499,157 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  // In-process streams cannot reach another process, and ships come from
+  // one source
+  if ((transportName == "local" && role != "all") ||
+      (!arrivals.tracePath.empty() && arrivals.pattern)) {
+    printUsage();
+    return 1;
+  }
+
+  if (simulate || !sweepGrid.empty()) {
+    ecuafast::SimulationConfig config;
+    config.timeout = timeout;
+    config.unloadTime = unloadTime;
+    config.maxSlots = maxSlots;
+    config.damageProb = damageProb;
+    config.averageWindow = averageWindow;
+    config.quantileMode = quantileMode;
+    config.retry = retryPolicy;
+    if (!sweepGrid.empty()) {
+      return runSweep(config, sweepGrid, shipCount, replicas);
+    }
+    if (!eventLogPath.empty()) {
+      ecuafast::eventLog().open(eventLogPath);
+    }
+    int status = runSimulation(config, shipCount, arrivals);
+    if (!ecuafast::eventLog().close()) {
+      std::cerr << "Error: could not write " << eventLogPath << "\n";
+      return 1;
+    }
+    return status;
+  }
+
   try {
-    // Start control entities
-    ecuafast::SRIServer sri(ecuafast::constants::DEFAULT_PORT_SRI);
-    ecuafast::SENAEServer senae(ecuafast::constants::DEFAULT_PORT_SENAE);
+    ecuafast::ThreadPool entityPool(std::thread::hardware_concurrency(),
+                                    queueDepth, rejectPolicy);
+    ecuafast::SRIServer sri(ecuafast::constants::DEFAULT_PORT_SRI,
+                            averageWindow);
+    ecuafast::SENAEServer senae(ecuafast::constants::DEFAULT_PORT_SENAE,
+                                quantileMode);
     ecuafast::SuperCIAServer supercia(
         ecuafast::constants::DEFAULT_PORT_SUPERCIA);
 
-    std::thread sriThread([&sri]() { sri.start(); });
-    std::thread senaeThread([&senae]() { senae.start(); });
-    std::thread superciaThread([&supercia]() { supercia.start(); });
-
-    // Start port manager
+    ecuafast::ThreadPool portPool(workerThreads, queueDepth, rejectPolicy);
     ecuafast::PortManager portManager(ecuafast::constants::DEFAULT_PORT_MANAGER,
-                                      maxSlots, damageProb, unloadTime);
-    std::thread portThread([&portManager]() { portManager.start(); });
+                                      maxSlots, damageProb, unloadTime,
+                                      portPool);
+
+    // Control entities and the port manager share one reactor. It is
+    // declared after them so its loops stop before the servers they call
+    // into, and the transport's listeners go before the reactor.
+    ecuafast::Reactor reactor(loopThreads);
+    std::unique_ptr<ecuafast::Transport> transport =
+        makeTransport(transportName);
+
+    if (role != "ships") {
+      sri.start(*transport, reactor, entityPool);
+      senae.start(*transport, reactor, entityPool);
+      supercia.start(*transport, reactor, entityPool);
+      portManager.start(*transport, reactor);
+    }
+
+    // A server process runs until it is killed
+    if (role == "servers") {
+      while (true) {
+        pause();
+      }
+    }
 
-    // Create and start ships
-    std::vector<std::thread> shipThreads;
-    for (int i = 0; i < shipCount; ++i) {
-      ecuafast::ShipInfo info{
-          static_cast<ecuafast::ShipType>(
-              ecuafast::utils::generateRandomProbability() > 0.5),
-          50000 + ecuafast::utils::generateRandomProbability() * 50000,
-          ecuafast::utils::generateRandomProbability() > 0.5
-              ? "Ecuador"
-              : (ecuafast::utils::generateRandomProbability() > 0.5 ? "USA"
-                                                                    : "Europe"),
-          i, false};
+    // Ships share a few long-lived connections per entity
+    ecuafast::Reactor clientReactor(loopThreads);
+    double latencyQuantile =
+        retryPolicy.hedgeQuantile > 0 ? retryPolicy.hedgeQuantile : 0.95;
+    // Two rounds, so a reply to an earlier attempt can still land after a
+    // retry went out
+    double requestExpiry = 2.0 * timeout;
+    ecuafast::EntityChannels entities{
+        {*transport, clientReactor, ecuafast::constants::DEFAULT_PORT_SRI,
+         entityConnections, wireFormat, latencyQuantile, batchSize,
+         requestExpiry},
+        {*transport, clientReactor, ecuafast::constants::DEFAULT_PORT_SENAE,
+         entityConnections, wireFormat, latencyQuantile, batchSize,
+         requestExpiry},
+        {*transport, clientReactor, ecuafast::constants::DEFAULT_PORT_SUPERCIA,
+         entityConnections, wireFormat, latencyQuantile, batchSize,
+         requestExpiry}};
 
-      shipThreads.emplace_back([info, timeout]() {
-        ecuafast::ShipClient ship(info, timeout);
-        ship.start();
-      });
+    // Ships sail as coroutines spread over the client loops. In-process
+    // streams hold no descriptors, so every ship can sail at once.
+    size_t limit = shipsInFlight;
+    if (limit == 0) {
+      limit = transportName == "local" ? std::numeric_limits<size_t>::max()
+                                       : defaultShipsInFlight();
     }
 
-    // Wait for all ships to finish
-    for (auto& thread : shipThreads) {
-      thread.join();
+    ecuafast::LatencyRecorder latencies;
+    if (arrivals.streamed()) {
+      ArrivalSource source = arrivals.open(shipCount);
+
+      // Times are taken from here; a server process never gets to write one
+      if (!eventLogPath.empty()) {
+        ecuafast::eventLog().open(eventLogPath);
+      }
+      sailArrivals(source, limit, timeout, retryPolicy, entities, *transport,
+                   clientReactor, latencies);
+    } else {
+      // Create ships up front, so sailing them draws nothing extra
+      std::vector<ecuafast::ShipInfo> ships;
+      ships.reserve(shipCount);
+      for (int i = 0; i < shipCount; ++i) {
+        ships.push_back(ecuafast::utils::generateRandomShip(i));
+      }
+
+      size_t lanes = std::max<size_t>(1, std::min(ships.size(), limit));
+      std::atomic<size_t> nextShip{0};
+      std::latch finished(lanes);
+
+      if (!eventLogPath.empty()) {
+        ecuafast::eventLog().open(eventLogPath);
+      }
+
+      for (size_t lane = 0; lane < lanes; ++lane) {
+        ecuafast::EventLoop* loop = &clientReactor.nextLoop();
+        loop->post([&, loop, timeout]() {
+          ecuafast::spawn(sailShips(ships, nextShip, timeout, retryPolicy,
+                                    entities, *transport, *loop, finished));
+        });
+      }
+
+      // Wait for all ships to finish
+      finished.wait();
     }
 
+    // Let queued work finish while the servers it refers to still exist
+    portPool.shutdown();
+    entityPool.shutdown();
+
     std::cout << "Simulation completed.\n";
+    if (size_t rejected = portPool.rejectedCount()) {
+      std::cout << "Port manager turned away " << rejected
+                << " requests on a full queue\n";
+    }
+    if (size_t rejected = entityPool.rejectedCount()) {
+      std::cout << "Entities dropped " << rejected
+                << " requests on a full queue\n";
+    }
+    if (arrivals.streamed()) {
+      latencies.report(std::cout);
+    }
+    if (!ecuafast::eventLog().close()) {
+      std::cerr << "Error: could not write " << eventLogPath << "\n";
+      return 1;
+    }
     return 0;
 
   } catch (const std::exception& e) {
@@ -9,71 +9,123 @@
 namespace ecuafast {
 
 PortManager::PortManager(int port, int maxSlots, double damageProb,
-                         int unloadTime)
-    : port(port),
+                         int unloadTime, ThreadPool& clientPool)
+    : unloadTimers(std::chrono::milliseconds(1)),
+      clientPool(clientPool),
+      shutdown(false),
       maxSlots(maxSlots),
       damageProb(damageProb),
       unloadTime(unloadTime),
-      shutdown(false) {
-  dockingSlots.resize(maxSlots, {false, nullptr, 0, 0});
+      port(port) {
+  dockingSlots.resize(maxSlots);
+  slotByShip.reserve(maxSlots);
+
+  // One bit per berth, all free; bits past maxSlots stay clear forever
+  freeSlotWords = (maxSlots + 63) / 64;
+  freeSlots.reset(new std::atomic<uint64_t>[freeSlotWords]);
+  for (size_t word = 0; word < freeSlotWords; ++word) {
+    int remaining = maxSlots - static_cast<int>(word) * 64;
+    freeSlots[word] = remaining >= 64 ? ~uint64_t{0}
+                                      : (uint64_t{1} << remaining) - 1;
+  }
+
+  unloadThread = std::thread([this]() { processQueue(); });
+}
 
-  // Initialize worker threads
-  for (int i = 0; i < maxSlots; ++i) {
-    workerThreads.emplace_back([this]() { processQueue(); });
+PortManager::~PortManager() {
+  {
+    std::lock_guard<std::mutex> lock(slotsMutex);
+    shutdown = true;
   }
+  slotsCV.notify_all();
+  unloadThread.join();
 }
 
-void PortManager::start() {
-  int serverSocket = SocketWrapper::createServerSocket(port);
+void PortManager::start(Transport& transport, Reactor& reactor) {
+  transport.listen(
+      port, reactor, [this](const std::shared_ptr<MessageStream>& stream) {
+        auto client = std::make_shared<Client>();
+        stream->start([this, client](const std::shared_ptr<MessageStream>& from,
+                                     const std::string& message) {
+          handleMessage(from, client, message);
+        });
+      });
+}
 
-  while (!shutdown) {
-    sockaddr_in clientAddr{};
-    socklen_t clientLen = sizeof(clientAddr);
-    int clientSocket =
-        accept(serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
-
-    if (clientSocket >= 0) {
-      std::thread([this, clientSocket]() {
-        this->handleClient(clientSocket);
-      }).detach();
-    }
-  }
+bool PortManager::requestDocking(const ShipInfo& /*ship*/) {
+  // Just check if any slot is available
+  return hasFreeSlot();
+}
 
-  // Cleanup
-  for (auto& thread : workerThreads) {
-    thread.join();
+bool PortManager::hasFreeSlot() const {
+  for (size_t word = 0; word < freeSlotWords; ++word) {
+    if (freeSlots[word].load(std::memory_order_acquire) != 0) {
+      return true;
+    }
   }
+  return false;
 }
 
-bool PortManager::requestDocking(int clientSocket, const ShipInfo& ship) {
-  std::lock_guard<std::mutex> lock(slotsMutex);
+int PortManager::claimSlot() {
+  for (size_t word = 0; word < freeSlotWords; ++word) {
+    uint64_t bits = freeSlots[word].load(std::memory_order_acquire);
 
-  // std::cout << "Received docking request for " << ship.id << "\n";
+    while (bits != 0) {
+      int bit = __builtin_ctzll(bits);
+      uint64_t claimed = bits & ~(uint64_t{1} << bit);
+      if (freeSlots[word].compare_exchange_weak(bits, claimed,
+                                                std::memory_order_acq_rel)) {
+        return static_cast<int>(word * 64 + bit);
+      }
+      // bits was reloaded by the failed CAS; try its lowest free berth
+    }
+  }
+  return -1;
+}
 
-  // Just check if any slot is available
-  auto availableSlot =
-      std::find_if(dockingSlots.begin(), dockingSlots.end(),
-                   [](const PortSlot& slot) { return !slot.occupied; });
+void PortManager::freeSlot(size_t index) {
+  freeSlots[index / 64].fetch_or(uint64_t{1} << (index % 64),
+                                 std::memory_order_release);
+}
 
-  return availableSlot != dockingSlots.end();
+// Caller holds slotsMutex
+void PortManager::clearSlot(size_t index) {
+  PortSlot& slot = dockingSlots[index];
+  if (slot.occupied) {
+    slotByShip.erase(slot.ship.id);
+  }
+  if (slot.unloadTimer != 0) {
+    unloadTimers.cancel(slot.unloadTimer);
+    slot.unloadTimer = 0;
+  }
+  slot.occupied = false;
+  slot.arrivalTime = 0;
+  slot.departureTime = 0;
+  freeSlot(index);
 }
 
 void PortManager::doInspection(const ShipInfo& ship) {
   std::cout << "Ship " << ship.id << " starting inspection\n";
 
-  std::lock_guard<std::mutex> lock(slotsMutex);
+  // Claim the lowest free berth
+  int index = claimSlot();
+
+  if (index >= 0) {
+    // The claimed berth is ours alone until it is marked occupied, so the
+    // copy happens outside the lock
+    PortSlot& emptySlot = dockingSlots[index];
+    emptySlot.ship = ship;
+
+    std::lock_guard<std::mutex> lock(slotsMutex);
 
-  // Find first empty slot
-  auto emptySlot =
-      std::find_if(dockingSlots.begin(), dockingSlots.end(),
-                   [](const PortSlot& slot) { return !slot.occupied; });
+    // Only mark as occupied and set the arrival time
+    emptySlot.occupied = true;
+    emptySlot.arrivalTime = std::time(nullptr);
+    emptySlot.departureTime = 0;  // Will be set by processQueue
+    slotByShip[ship.id] = index;
 
-  if (emptySlot != dockingSlots.end()) {
-    // Only mark as occupied and set the ship info
-    emptySlot->occupied = true;
-    emptySlot->ship = new ShipInfo(ship);
-    emptySlot->arrivalTime = std::time(nullptr);
-    emptySlot->departureTime = 0;  // Will be set by processQueue
+    bool priority = ship.needsInspection && ship.destination != "Ecuador";
+    readyShips.push({static_cast<size_t>(index), ship.id}, priority);
   }
 
   // Notify one worker that new work is available
@@ -81,98 +133,105 @@ void PortManager::doInspection(const ShipInfo& ship) {
 }
 
 void PortManager::processQueue() {
-  while (!shutdown) {
-    ShipInfo* shipToProcess = nullptr;
-    std::list<PortSlot>::iterator slotToProcess;
-
-    // Wait for work
-    {
-      std::unique_lock<std::mutex> lock(slotsMutex);
-      slotsCV.wait(lock, [this]() {
-        return shutdown || std::any_of(dockingSlots.begin(), dockingSlots.end(),
-                                       [](const PortSlot& slot) {
-                                         return slot.occupied &&
-                                                slot.ship != nullptr &&
-                                                slot.departureTime == 0;
-                                       });
-      });
+  std::unique_lock<std::mutex> lock(slotsMutex);
+  std::vector<TimerWheel::Callback> expired;
+  std::vector<std::pair<int, int>> started;  // ship id, unload time
 
-      if (shutdown) {
-        return;
+  while (!shutdown) {
+    // Start every ship that docked since the last pass, priority ships first
+    while (!readyShips.empty()) {
+      ReadyQueue::Entry entry = readyShips.pop();
+      int processTime = startUnload(entry);
+      if (processTime >= 0) {
+        started.emplace_back(entry.shipId, processTime);
       }
+    }
 
-      // First look for priority ships that haven't been processed
-      auto it = std::find_if(
-          dockingSlots.begin(), dockingSlots.end(), [](const PortSlot& slot) {
-            return slot.occupied && slot.ship != nullptr &&
-                   slot.departureTime == 0 &&  // Not yet processed
-                   slot.ship->needsInspection &&
-                   slot.ship->destination != "Ecuador";
-          });
-
-      // If no priority ships, get first unprocessed ship
-      if (it == dockingSlots.end()) {
-        it = std::find_if(
-            dockingSlots.begin(), dockingSlots.end(), [](const PortSlot& slot) {
-              return slot.occupied && slot.ship != nullptr &&
-                     slot.departureTime == 0;  // Not yet processed
-            });
+    // Announced without holding up docking ships
+    if (!started.empty()) {
+      lock.unlock();
+      for (auto [shipId, processTime] : started) {
+        std::cout << "Ship " << shipId << " starting unload process ("
+                  << processTime << " seconds)\n";
+        eventLog().record(shipId, "unloading");
       }
-
-      if (it != dockingSlots.end()) {
-        slotToProcess = it;
-        shipToProcess = it->ship;
-
-        // Calculate processing time
-        int processTime = unloadTime;
-        if (shipToProcess->destination != "Ecuador") {
-          processTime /= 2;
-        }
-        if (shipToProcess->needsInspection) {
-          processTime *= 2;
-        }
-
-        // Set departure time to mark as being processed
-        it->departureTime = it->arrivalTime + processTime;
+      started.clear();
+      lock.lock();
+      if (!readyShips.empty()) {
+        continue;
       }
     }
 
-    if (shipToProcess) {
-      int processTime =
-          slotToProcess->departureTime - slotToProcess->arrivalTime;
-
-      std::cout << "Ship " << shipToProcess->id << " starting unload process ("
-                << processTime << " seconds)\n";
-
-      // Simulate processing time
-      std::this_thread::sleep_for(std::chrono::seconds(processTime));
+    // Sleep until the next unload can finish, or until a ship docks if none
+    // is unloading
+    auto woken = [this]() { return shutdown || !readyShips.empty(); };
+    if (unloadTimers.empty()) {
+      slotsCV.wait(lock, woken);
+    } else {
+      slotsCV.wait_until(lock, unloadTimers.nextExpiry(), woken);
+    }
 
-      std::cout << "Ship " << shipToProcess->id << " finished unloading\n";
+    unloadTimers.advance(TimerWheel::Clock::now(), expired);
 
-      // Release the slot
-      releaseSlot(shipToProcess->id);
+    // Completions take slotsMutex themselves through releaseSlot
+    if (!expired.empty()) {
+      lock.unlock();
+      for (auto& callback : expired) {
+        callback();
+      }
+      expired.clear();
+      lock.lock();
     }
   }
 }
 
-void PortManager::releaseSlot(int shipId) {
-  std::lock_guard<std::mutex> lock(slotsMutex);
+// Caller holds slotsMutex
+int PortManager::startUnload(const ReadyQueue::Entry& entry) {
+  PortSlot& slot = dockingSlots[entry.slot];
 
-  auto it = std::find_if(
-      dockingSlots.begin(), dockingSlots.end(), [shipId](const PortSlot& slot) {
-        return slot.occupied && slot.ship != nullptr && slot.ship->id == shipId;
+  // Skip entries whose ship was removed by a damage event; the berth may
+  // already hold someone else
+  if (!slot.occupied || slot.ship.id != entry.shipId ||
+      slot.departureTime != 0) {
+    return -1;
+  }
+
+  int shipId = slot.ship.id;
+
+  // Calculate processing time
+  int processTime = unloadTime;
+  if (slot.ship.destination != "Ecuador") {
+    processTime /= 2;
+  }
+  if (slot.ship.needsInspection) {
+    processTime *= 2;
+  }
+
+  // Set departure time to mark as being processed
+  slot.departureTime = slot.arrivalTime + processTime;
+
+  // Cancelled by clearSlot if a damage event frees the berth first
+  slot.unloadTimer = unloadTimers.schedule(
+      utils::scaledSeconds(processTime), [this, shipId]() {
+        std::cout << "Ship " << shipId << " finished unloading\n";
+        eventLog().record(shipId, "departed");
+        releaseSlot(shipId);
       });
+  return processTime;
+}
 
-  if (it != dockingSlots.end()) {
-    std::cout << "Releasing slot for ship " << shipId << "\n";
-    delete it->ship;
-    it->ship = nullptr;
-    it->occupied = false;
-    it->arrivalTime = 0;
-    it->departureTime = 0;
+void PortManager::releaseSlot(int shipId) {
+  {
+    std::lock_guard<std::mutex> lock(slotsMutex);
+
+    auto it = slotByShip.find(shipId);
+    if (it == slotByShip.end()) {
+      return;
+    }
+    clearSlot(it->second);
   }
 
-  slotsCV.notify_all();
+  std::cout << "Releasing slot for ship " << shipId << "\n";
 }
 
 void PortManager::handleDamageEvent() {
@@ -182,52 +241,62 @@ void PortManager::handleDamageEvent() {
                          [](const PortSlot& slot) { return slot.occupied; });
 
   if (it != dockingSlots.end()) {
-    delete it->ship;
-    it->ship = nullptr;
-    it->occupied = false;
-    std::rotate(it, std::next(it), dockingSlots.end());
+    clearSlot(it - dockingSlots.begin());
   }
 }
 
-void PortManager::handleClient(int clientSocket) {
-  char buffer[1024] = {0};  // Initialize buffer to zero
-  ssize_t bytesRead = read(clientSocket, buffer, sizeof(buffer));
-
-  int shipId;
-
-  if (bytesRead > 0) {
-    auto j = nlohmann::json::parse(buffer);
-    ShipInfo ship = ShipInfo::from_json(j);
-    shipId = ship.id;
+void PortManager::handleMessage(const std::shared_ptr<MessageStream>& stream,
+                                const std::shared_ptr<Client>& client,
+                                const std::string& message) {
+  ShipInfo ship;
+  if (!ship_json::parse(message, ship)) {
+    std::cerr << "Error processing request: malformed ship\n";
+    stream->close();
+    return;
+  }
 
-    bool responseBool = requestDocking(clientSocket, ship);
-    std::string responseStr = responseBool ? constants::RESPONSE_ACCEPTED
-                                           : constants::RESPONSE_REJECTED;
-    send(clientSocket, responseStr.c_str(), responseStr.length(), 0);
+  // This runs on the shared reactor thread, so a full pool never stalls it:
+  // the -r policy parks the task, turns the ship away or runs it here
+  bool queued;
+  if (!client->docked) {
+    queued = clientPool.dispatch([this, stream, client, ship]() {
+      handleDocking(stream, *client, ship);
+    });
+  } else {
+    queued = clientPool.dispatch([this, stream, ship]() {
+      doInspection(ship);
+      stream->close();
+    });
+  }
 
-    if (!responseBool) {
-      close(clientSocket);
-      return;
-    }
+  if (!queued) {
+    // Overloaded: the ship sees an empty reply and cannot dock
+    stream->close();
   }
+}
 
-  if (utils::generateRandomProbability() < damageProb) {
-    handleDamageEvent();
-    std::cout << "Ship " << shipId << " is broken and was removed\n";
-    close(clientSocket);
+void PortManager::handleDocking(const std::shared_ptr<MessageStream>& stream,
+                                Client& client, const ShipInfo& ship) {
+  if (!requestDocking(ship)) {
+    eventLog().record(ship.id, "rejected");
+    stream->send(constants::RESPONSE_REJECTED);
+    stream->closeAfterWrite();
     return;
   }
 
-  memset(buffer, 0, sizeof(buffer));  // Clear buffer before second read
-  bytesRead = read(clientSocket, buffer, sizeof(buffer));
-
-  if (bytesRead > 0) {
-    auto j = nlohmann::json::parse(buffer);
-    ShipInfo ship = ShipInfo::from_json(j);
-    doInspection(ship);
+  // A damaged ship never gets to send its inspection; the roll happens
+  // before the reply so a quick ship cannot slip one in
+  if (random::uniform(random::Draw::DAMAGE, ship.id) < damageProb) {
+    handleDamageEvent();
+    std::cout << "Ship " << ship.id << " is broken and was removed\n";
+    eventLog().record(ship.id, "damaged");
+    stream->send(constants::RESPONSE_ACCEPTED);
+    stream->closeAfterWrite();
+    return;
   }
 
-  close(clientSocket);
+  client.docked = true;
+  stream->send(constants::RESPONSE_ACCEPTED);
 }
 
 }  // namespace ecuafast
\ No newline at end of file
@@ -1,36 +1,80 @@
 #pragma once
+#include <atomic>
 #include <condition_variable>
-#include <list>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "../common/constants.hpp"
-#include "../common/socket_wrapper.hpp"
+#include "../common/event_log.hpp"
+#include "../common/event_loop.hpp"
+#include "../common/ship_json.hpp"
+#include "../common/thread_pool.hpp"
+#include "../common/timer_wheel.hpp"
+#include "../common/transport.hpp"
 #include "../common/types.hpp"
 #include "../common/utils.hpp"
+#include "ready_queue.hpp"
 
 namespace ecuafast {
+// Ships talk to the port manager over streams on a Reactor: the docking
+// request first and, once it is accepted and the ship was cleared, the ship
+// again to start its inspection. Handling runs on the bounded client pool.
 class PortManager {
  public:
-  PortManager(int port, int maxSlots, double damageProb, int unloadTime);
-  void start();
-  bool requestDocking(int clientSocket, const ShipInfo& ship);
+  PortManager(int port, int maxSlots, double damageProb, int unloadTime,
+              ThreadPool& clientPool);
+  ~PortManager();
+
+  void start(Transport& transport, Reactor& reactor);
+  bool requestDocking(const ShipInfo& ship);
   void releaseSlot(int shipId);
 
  private:
-  std::list<PortSlot> dockingSlots;
+  // Set once a ship's docking was accepted, so its next message is the
+  // inspection; written on the pool, read on the stream's loop
+  struct Client {
+    std::atomic<bool> docked{false};
+  };
+
+  // Berths live in one contiguous array. A set bit in freeSlots marks a free
+  // berth; ships claim one by clearing the lowest set bit with a CAS, so the
+  // availability check never takes slotsMutex
+  std::vector<PortSlot> dockingSlots;
+  std::unique_ptr<std::atomic<uint64_t>[]> freeSlots;
+  size_t freeSlotWords;
+  std::unordered_map<int, size_t> slotByShip;
+  ReadyQueue readyShips;
   std::mutex slotsMutex;
   std::condition_variable slotsCV;
-  std::vector<std::thread> workerThreads;
+  // Every unload in progress is one timer; a single thread drives the wheel
+  TimerWheel unloadTimers;
+  std::thread unloadThread;
+  ThreadPool& clientPool;
   bool shutdown = false;
   int maxSlots;
   double damageProb;
   int unloadTime;
   int port;
 
+  bool hasFreeSlot() const;
+  int claimSlot();
+  void freeSlot(size_t index);
+  void clearSlot(size_t index);
+
   void handleDamageEvent();
-  void handleClient(int clientSocket);
+  void handleMessage(const std::shared_ptr<MessageStream>& stream,
+                     const std::shared_ptr<Client>& client,
+                     const std::string& message);
+  void handleDocking(const std::shared_ptr<MessageStream>& stream,
+                     Client& client, const ShipInfo& ship);
   void processQueue();
+  // Returns the unload time, or -1 if the ship is gone; caller holds
+  // slotsMutex
+  int startUnload(const ReadyQueue::Entry& entry);
   void doInspection(const ShipInfo& ship);
 };
-}  // namespace ecuafast
\ No newline at end of file
+}  // namespace ecuafast
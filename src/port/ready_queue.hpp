@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+
+namespace ecuafast {
+// Docked ships waiting for an unload worker. Ships that need inspection and
+// are bound abroad go ahead of everyone else; within each level the order is
+// FIFO. Not synchronized: PortManager guards it with slotsMutex.
+class ReadyQueue {
+ public:
+  struct Entry {
+    size_t slot;
+    int shipId;
+  };
+
+  void push(const Entry& entry, bool priority) {
+    (priority ? urgent : normal).push_back(entry);
+  }
+
+  bool empty() const { return urgent.empty() && normal.empty(); }
+
+  // Caller checks empty() first
+  Entry pop() {
+    std::deque<Entry>& level = urgent.empty() ? normal : urgent;
+    Entry entry = level.front();
+    level.pop_front();
+    return entry;
+  }
+
+ private:
+  std::deque<Entry> urgent;
+  std::deque<Entry> normal;
+};
+}  // namespace ecuafast
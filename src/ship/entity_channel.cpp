@@ -0,0 +1,294 @@
+#include "entity_channel.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "../common/constants.hpp"
+#include "../common/utils.hpp"
+
+namespace ecuafast {
+
+namespace {
+// Consecutive lost or timed-out requests before the breaker opens, and how
+// long it then stays open: the slowest an entity is ever meant to answer
+constexpr int BREAKER_THRESHOLD = 5;
+constexpr double BREAKER_COOLDOWN = 5.0;
+
+// P2 needs a handful of samples before its markers mean anything
+constexpr size_t MIN_LATENCY_SAMPLES = 20;
+
+// Even as JSON, a batch this size fits one shared-memory ring
+constexpr size_t MAX_BATCH_SIZE = 256;
+}  // namespace
+
+EntityChannel::Health::Health(double latencyQuantile)
+    : latency(latencyQuantile),
+      breaker(BREAKER_THRESHOLD, utils::scaledSeconds(BREAKER_COOLDOWN)) {}
+
+EntityChannel::EntityChannel(Transport& transport, Reactor& reactor, int port,
+                             int connections, WireFormat preferredFormat,
+                             double latencyQuantile, size_t batchSize,
+                             double expirySeconds)
+    : transport(transport),
+      reactor(reactor),
+      port(port),
+      preferredFormat(preferredFormat),
+      links(connections > 0 ? connections : 1),
+      pending(std::make_shared<PendingTable>()),
+      health(std::make_shared<Health>(latencyQuantile)),
+      batchSize(std::clamp<size_t>(batchSize, 1, MAX_BATCH_SIZE)),
+      batch(std::make_shared<Batch>()),
+      expirySeconds(expirySeconds) {}
+
+EntityChannel::~EntityChannel() {
+  // Waits out a flush in progress; ships still waiting to go out are lost
+  std::vector<ReplyCallback> unsent;
+  {
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    batch->closed = true;
+    unsent.swap(batch->callbacks);
+  }
+  for (auto& callback : unsent) {
+    callback("");
+  }
+
+  std::lock_guard<std::mutex> lock(linksMutex);
+  for (auto& link : links) {
+    if (link.connection) {
+      link.connection->close();
+    }
+  }
+}
+
+void EntityChannel::request(const ShipInfo& ship, ReplyCallback callback) {
+  if (batchSize <= 1) {
+    send({ship}, {std::move(callback)});
+    return;
+  }
+
+  std::vector<ShipInfo> ships;
+  std::vector<ReplyCallback> callbacks;
+  bool first;
+  {
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    batch->ships.push_back(ship);
+    batch->callbacks.push_back(std::move(callback));
+    first = batch->ships.size() == 1;
+    if (batch->ships.size() >= batchSize) {
+      ships.swap(batch->ships);
+      callbacks.swap(batch->callbacks);
+    }
+  }
+
+  if (!ships.empty()) {
+    send(std::move(ships), std::move(callbacks));
+  } else if (first) {
+    // Whatever is requested before the loop gets here rides along
+    std::weak_ptr<Batch> open = batch;
+    reactor.nextLoop().post([this, open]() {
+      if (std::shared_ptr<Batch> pendingBatch = open.lock()) {
+        flushBatch(pendingBatch, *this);
+      }
+    });
+  }
+}
+
+void EntityChannel::flushBatch(const std::shared_ptr<Batch>& batch,
+                               EntityChannel& channel) {
+  std::lock_guard<std::mutex> lock(batch->mutex);
+  if (batch->closed || batch->ships.empty()) {
+    return;
+  }
+
+  std::vector<ShipInfo> ships;
+  std::vector<ReplyCallback> callbacks;
+  ships.swap(batch->ships);
+  callbacks.swap(batch->callbacks);
+  channel.send(std::move(ships), std::move(callbacks));
+}
+
+void EntityChannel::send(std::vector<ShipInfo> ships,
+                         std::vector<ReplyCallback> callbacks) {
+  size_t index =
+      nextLink.fetch_add(1, std::memory_order_relaxed) % links.size();
+  uint64_t requestId = nextRequestId.fetch_add(1, std::memory_order_relaxed);
+
+  Link link;
+  try {
+    link = acquireLink(index);
+  } catch (const std::exception& e) {
+    health->breaker.recordFailure();
+    for (size_t i = 0; i < ships.size(); ++i) {
+      std::cerr << "Ship " << ships[i].id << " error: " << e.what() << "\n";
+      callbacks[i]("");
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(pending->mutex);
+    pending->requests[requestId] = {
+        link.connection.get(), EventLoop::Clock::now(), std::move(callbacks)};
+  }
+
+  std::weak_ptr<PendingTable> table = pending;
+  link.connection->loop().runAfter(
+      utils::scaledSeconds(expirySeconds), [table, requestId]() {
+        if (std::shared_ptr<PendingTable> live = table.lock()) {
+          expire(*live, requestId);
+        }
+      });
+
+  // A lone ship goes out as a plain request
+  if (ships.size() == 1) {
+    link.connection->send(
+        wire::encodeRequest(*link.format, requestId, ships.front()));
+  } else {
+    link.connection->send(
+        wire::encodeBatchRequest(*link.format, requestId, ships));
+  }
+}
+
+bool EntityChannel::available() { return health->breaker.allowRequest(); }
+
+void EntityChannel::reportTimeout() { health->breaker.recordFailure(); }
+
+std::optional<EventLoop::Clock::duration> EntityChannel::replyLatency() {
+  std::lock_guard<std::mutex> lock(health->latencyMutex);
+  if (health->latency.size() < MIN_LATENCY_SAMPLES) {
+    return std::nullopt;
+  }
+  return std::chrono::duration_cast<EventLoop::Clock::duration>(
+      std::chrono::duration<double>(health->latency.value()));
+}
+
+EntityChannel::Link EntityChannel::acquireLink(size_t index) {
+  std::lock_guard<std::mutex> lock(linksMutex);
+
+  Link& link = links[index];
+  if (link.connection && !link.connection->isClosed()) {
+    return link;
+  }
+
+  std::shared_ptr<PendingTable> table = pending;
+  std::shared_ptr<Health> stats = health;
+  auto format = std::make_shared<std::atomic<WireFormat>>(WireFormat::JSON);
+
+  link.format = format;
+  link.connection = transport.connect(reactor.nextLoop(), port);
+  link.connection->start(
+      [table, stats, format](const std::shared_ptr<MessageStream>&,
+                             const std::string& message) {
+        handleReply(*table, *stats, *format, message);
+      },
+      [table, stats](const std::shared_ptr<MessageStream>& closed) {
+        failPending(*table, *stats, closed.get());
+      });
+
+  if (preferredFormat != WireFormat::JSON) {
+    link.connection->send(wire::encodeHello(preferredFormat));
+  }
+
+  return link;
+}
+
+void EntityChannel::handleReply(PendingTable& table, Health& health,
+                                std::atomic<WireFormat>& format,
+                                const std::string& message) {
+  WireFormat accepted;
+  if (wire::decodeHello(message, accepted)) {
+    format = accepted;
+    return;
+  }
+
+  std::vector<ReplyCallback> callbacks;
+  std::vector<std::string> responses;
+  EventLoop::Clock::time_point sentAt;
+
+  try {
+    uint64_t requestId;
+    if (wire::isBatch(message)) {
+      VerdictBitmap verdicts;
+      wire::decodeBatchReply(message, requestId, verdicts);
+      for (size_t i = 0; i < verdicts.size(); ++i) {
+        responses.push_back(verdicts.check(i) ? constants::RESPONSE_CHECK
+                                              : constants::RESPONSE_PASS);
+      }
+    } else {
+      responses.emplace_back();
+      wire::decodeReply(message, requestId, responses.back());
+    }
+
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.requests.find(requestId);
+    if (it == table.requests.end()) {
+      return;
+    }
+    callbacks = std::move(it->second.callbacks);
+    sentAt = it->second.sentAt;
+    table.requests.erase(it);
+  } catch (const std::exception& e) {
+    std::cerr << "Error processing reply: " << e.what() << "\n";
+    return;
+  }
+
+  health.breaker.recordSuccess();
+  {
+    std::chrono::duration<double> elapsed = EventLoop::Clock::now() - sentAt;
+    std::lock_guard<std::mutex> lock(health.latencyMutex);
+    health.latency.insert(elapsed.count());
+  }
+
+  // A reply that does not cover every ship loses the rest
+  responses.resize(callbacks.size());
+  for (size_t i = 0; i < callbacks.size(); ++i) {
+    callbacks[i](responses[i]);
+  }
+}
+
+void EntityChannel::failPending(PendingTable& table, Health& health,
+                                const MessageStream* link) {
+  std::vector<ReplyCallback> lost;
+  size_t lostRequests = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    for (auto it = table.requests.begin(); it != table.requests.end();) {
+      if (it->second.link == link) {
+        for (auto& callback : it->second.callbacks) {
+          lost.push_back(std::move(callback));
+        }
+        lostRequests++;
+        it = table.requests.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < lostRequests; ++i) {
+    health.breaker.recordFailure();
+  }
+  for (auto& callback : lost) {
+    callback("");
+  }
+}
+
+void EntityChannel::expire(PendingTable& table, uint64_t requestId) {
+  std::vector<ReplyCallback> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.requests.find(requestId);
+    if (it == table.requests.end()) {
+      return;
+    }
+    callbacks = std::move(it->second.callbacks);
+    table.requests.erase(it);
+  }
+
+  for (auto& callback : callbacks) {
+    callback("");
+  }
+}
+
+}  // namespace ecuafast
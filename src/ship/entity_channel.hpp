@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/circuit_breaker.hpp"
+#include "../common/event_loop.hpp"
+#include "../common/quantile.hpp"
+#include "../common/transport.hpp"
+#include "../common/types.hpp"
+#include "../common/wire_format.hpp"
+
+namespace ecuafast {
+// Long-lived connections to one control entity shared by every ship. Each
+// request carries an ID so replies are matched to callers rather than to
+// sockets, and many evaluations can be in flight on the same connection.
+// Requests go out as JSON until the entity acknowledges the preferred wire
+// format for that connection. The channel also tracks reply latency and
+// keeps a circuit breaker, so ships can hedge slow requests and stop asking
+// an entity that keeps timing out. With a batch size above one, requests
+// made before a loop gets to send them go out together as one batch.
+// Entities drop requests when overloaded, so a request still unanswered
+// after `expirySeconds` (simulated) is given up as lost.
+class EntityChannel {
+ public:
+  using ReplyCallback = std::function<void(const std::string& response)>;
+
+  EntityChannel(Transport& transport, Reactor& reactor, int port,
+                int connections,
+                WireFormat preferredFormat = WireFormat::BINARY,
+                double latencyQuantile = 0.95, size_t batchSize = 1,
+                double expirySeconds = 10.0);
+  ~EntityChannel();
+
+  // The callback runs on a loop thread; an empty response means the
+  // request was lost together with its connection, or expired
+  void request(const ShipInfo& ship, ReplyCallback callback);
+
+  // False while the circuit breaker is open
+  bool available();
+  // A request went unanswered for a whole timeout
+  void reportTimeout();
+  // Reply latency at the configured quantile, once enough replies came back
+  std::optional<EventLoop::Clock::duration> replyLatency();
+
+ private:
+  // One callback per ship, in batch order
+  struct PendingRequest {
+    const MessageStream* link;
+    EventLoop::Clock::time_point sentAt;
+    std::vector<ReplyCallback> callbacks;
+  };
+
+  // Shared with the connection handlers so late replies never touch a
+  // destroyed channel
+  struct PendingTable {
+    std::unordered_map<uint64_t, PendingRequest> requests;
+    std::mutex mutex;
+  };
+
+  // Shared with reply callbacks for the same reason
+  struct Health {
+    std::mutex latencyMutex;
+    P2Quantile latency;
+    CircuitBreaker breaker;
+
+    explicit Health(double latencyQuantile);
+  };
+
+  // Requests waiting to go out together. Flushes run under the mutex and
+  // the destructor closes the batch under it first, so a flush that finds
+  // the batch open has a live channel.
+  struct Batch {
+    std::mutex mutex;
+    bool closed = false;
+    std::vector<ShipInfo> ships;
+    std::vector<ReplyCallback> callbacks;
+  };
+
+  struct Link {
+    std::shared_ptr<MessageStream> connection;
+    std::shared_ptr<std::atomic<WireFormat>> format;
+  };
+
+  Transport& transport;
+  Reactor& reactor;
+  int port;
+  WireFormat preferredFormat;
+  std::vector<Link> links;
+  std::mutex linksMutex;
+  std::atomic<size_t> nextLink{0};
+  std::atomic<uint64_t> nextRequestId{1};
+  std::shared_ptr<PendingTable> pending;
+  std::shared_ptr<Health> health;
+  size_t batchSize;
+  std::shared_ptr<Batch> batch;
+  double expirySeconds;
+
+  void send(std::vector<ShipInfo> ships, std::vector<ReplyCallback> callbacks);
+  static void flushBatch(const std::shared_ptr<Batch>& batch,
+                         EntityChannel& channel);
+  Link acquireLink(size_t index);
+  // Breaker and latency outcomes are recorded once per message sent, however
+  // many ships it carries
+  static void handleReply(PendingTable& table, Health& health,
+                          std::atomic<WireFormat>& format,
+                          const std::string& message);
+  static void failPending(PendingTable& table, Health& health,
+                          const MessageStream* link);
+  // Silence is already reported by the ships, so this feeds no breaker
+  static void expire(PendingTable& table, uint64_t requestId);
+};
+
+// One channel per control entity
+struct EntityChannels {
+  EntityChannel sri;
+  EntityChannel senae;
+  EntityChannel supercia;
+};
+}  // namespace ecuafast
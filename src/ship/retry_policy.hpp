@@ -0,0 +1,33 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+namespace ecuafast {
+// How a ship keeps asking for verdicts when entities are slow. Durations are
+// in simulated seconds and go through the time scale.
+struct RetryPolicy {
+  // Budget for the whole inspection decision; once spent, entities that have
+  // not answered count as CHECK. 0 waits as long as it takes.
+  double deadline = 0.0;
+
+  // Pause before retry n is drawn from [cap / 2, cap], with cap =
+  // min(backoffMax, backoffBase * 2^(n - 1)): never less than half the cap,
+  // so retries spread out without collapsing back into a stampede.
+  // 0 retries immediately.
+  double backoffBase = 0.5;
+  double backoffMax = 8.0;
+
+  // Send one duplicate request to an entity that is still silent after this
+  // quantile of its observed reply latency. 0 disables hedging.
+  double hedgeQuantile = 0.0;
+
+  // Pause before retry n (from 1), given a uniform draw in [0, 1)
+  double backoff(int retry, double draw) const {
+    if (backoffBase <= 0) {
+      return 0.0;
+    }
+    double cap = std::min(backoffMax, backoffBase * std::pow(2.0, retry - 1));
+    return cap * (0.5 + 0.5 * draw);
+  }
+};
+}  // namespace ecuafast
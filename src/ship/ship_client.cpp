@@ -1,34 +1,28 @@
 #include "ship_client.hpp"
 
-#include <bits/this_thread_sleep.h>
-
-#include <future>
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 namespace ecuafast {
 
-ShipClient::ShipClient(const ShipInfo& info, int timeout)
-    : info(info), timeout(timeout) {
-  try {
-    portManagerClientSocket = SocketWrapper::createClientSocket(
-        constants::DEFAULT_HOST, constants::DEFAULT_PORT_MANAGER);
-  } catch (const std::exception& e) {
-    std::cerr << "Ship " << info.id << " error: " << e.what() << "\n";
-  }
-}
+ShipClient::ShipClient(const ShipInfo& info, int timeout,
+                       const RetryPolicy& policy, EntityChannels& entities,
+                       Transport& transport, EventLoop& loop)
+    : info(info),
+      timeout(timeout),
+      policy(policy),
+      entities(entities),
+      loop(loop),
+      portManagerStream(transport, loop) {}
 
-void ShipClient::start() {
-  try {
-    std::vector<std::future<bool>> responses;
+Task<> ShipClient::start() {
+  eventLog().record(info.id, "arrived");
 
+  try {
     // Request for inspection and docking in parallel
-    responses.push_back(std::async(std::launch::async,
-                                   [this]() { return requestInspection(); }));
-    responses.push_back(
-        std::async(std::launch::async, [this]() { return requestDocking(); }));
-
-    bool needInspection = responses.at(0).get();
-    bool canDock = responses.at(1).get();
+    auto [needInspection, canDock] =
+        co_await whenAll(requestInspection(), requestDocking());
 
     if (needInspection && canDock) {
       doInspection();
@@ -37,110 +31,235 @@ void ShipClient::start() {
   } catch (const std::exception& e) {
     std::cerr << "Ship " << info.id << " error: " << e.what() << "\n";
   }
+
+  // Lets the port manager stop waiting on this ship
+  portManagerStream.close();
+
+  // Keeps the seeded streams from growing with every ship that ever sailed
+  random::forget(info.id);
 }
 
-std::string ShipClient::connectToEntity(int port) {
-  try {
-    int clientSocket =
-        SocketWrapper::createClientSocket(constants::DEFAULT_HOST, port);
+std::optional<bool> ShipClient::Ballot::decision(bool missingAsCheck) const {
+  int checks = 0;
+  int passes = 0;
+  for (const auto& verdict : verdicts) {
+    if (verdict) {
+      (*verdict == constants::RESPONSE_CHECK ? checks : passes)++;
+    } else if (missingAsCheck) {
+      checks++;
+    }
+  }
 
-    // Send ship info
-    nlohmann::json jsonShip = info.to_json();
-    std::string jsonStr = jsonShip.dump();
-    send(clientSocket, jsonStr.c_str(), jsonStr.length(), 0);
+  if (checks >= 2) {
+    return true;
+  }
+  if (passes >= 2) {
+    return false;
+  }
+  return std::nullopt;
+}
 
-    // Receive response
-    char buffer[1024] = {0};
-    read(clientSocket, buffer, sizeof(buffer));
+void ShipClient::Ballot::wake() {
+  if (auto handle = std::exchange(waiter, {})) {
+    handle.resume();
+  }
+}
 
-    close(clientSocket);
-    return std::string(buffer);
+void ShipClient::requestVerdict(EntityChannel& entity,
+                                const std::shared_ptr<Ballot>& ballot,
+                                int index) {
+  // Sent over the entity's shared connections; the reply comes in on
+  // whichever loop owns that connection and is handed back to ours
+  EventLoop& shipLoop = loop;
+  entity.request(info, [ballot, index, &shipLoop](const std::string& response) {
+    shipLoop.post([ballot, index, response]() {
+      // A lost request (empty response) is asked again next round. An
+      // earlier attempt may also answer after a retry; the first one counts.
+      if (response.empty() || ballot->verdicts[index]) {
+        return;
+      }
+      ballot->verdicts[index] = response;
+      ballot->wake();
+    });
+  });
+}
 
-  } catch (const std::exception& e) {
-    std::cerr << "Ship " << info.id << " error: " << e.what() << "\n";
-    return "";
+Task<std::optional<bool>> ShipClient::collectVotes(
+    std::shared_ptr<Ballot> ballot, EventLoop::Clock::time_point until) {
+  // Timers cannot be cancelled, so a stale one must not end a later wait
+  int wait = ++ballot->wait;
+  ballot->timedOut = false;
+
+  EventLoop::Clock::time_point now = EventLoop::Clock::now();
+  if (until > now) {
+    loop.runAfter(until - now, [ballot, wait]() {
+      if (ballot->wait == wait) {
+        ballot->timedOut = true;
+        ballot->wake();
+      }
+    });
+  } else {
+    ballot->timedOut = true;
   }
+
+  std::optional<bool> decision;
+  while (!(decision = ballot->decision()) && !ballot->timedOut) {
+    co_await BallotAwaiter(*ballot);
+  }
+  co_return decision;
 }
 
-bool ShipClient::requestInspection() {
+EventLoop::Clock::duration ShipClient::backoff(int retry) {
+  return utils::scaledSeconds(
+      policy.backoff(retry, random::uniform(random::Draw::BACKOFF, info.id)));
+}
+
+bool ShipClient::decide(bool needsInspection) {
+  info.needsInspection = needsInspection;
+  eventLog().record(info.id, needsInspection ? "check" : "pass");
+
+  std::cout << "Ship " << info.id
+            << (info.needsInspection ? " requires" : " does not require")
+            << " inspection\n";
+
+  return info.needsInspection;
+}
+
+Task<bool> ShipClient::requestInspection() {
   std::cout << "Ship " << info.id << " starting inspection request\n";
 
-  int checkCount = 0;
-
-  while (true) {
-    checkCount = 0;
-    std::vector<std::future<std::string>> responses;
-
-    // Connect to all three entities in parallel
-    responses.push_back(std::async(std::launch::async, [this]() {
-      return connectToEntity(constants::DEFAULT_PORT_SRI);
-    }));
-    responses.push_back(std::async(std::launch::async, [this]() {
-      return connectToEntity(constants::DEFAULT_PORT_SENAE);
-    }));
-    responses.push_back(std::async(std::launch::async, [this]() {
-      return connectToEntity(constants::DEFAULT_PORT_SUPERCIA);
-    }));
-
-    bool allResponsesReceived = true;
-
-    // Wait for responses with timeout
-    for (auto& future : responses) {
-      if (future.wait_for(std::chrono::seconds(timeout)) ==
-          std::future_status::ready) {
-        std::string response = future.get();
-
-        if (response == constants::RESPONSE_CHECK) {
-          checkCount++;
-        }
-      } else {
-        // A response timed out; retry the whole process
-        allResponsesReceived = false;
+  using Clock = EventLoop::Clock;
+  auto ballot = std::make_shared<Ballot>();
+  EntityChannel* channels[ENTITY_COUNT] = {&entities.sri, &entities.senae,
+                                           &entities.supercia};
+
+  std::optional<Clock::time_point> deadline;
+  if (policy.deadline > 0) {
+    deadline = Clock::now() + utils::scaledSeconds(policy.deadline);
+  }
+  auto clip = [&deadline](Clock::time_point when) {
+    return deadline ? std::min(when, *deadline) : when;
+  };
+  auto outOfTime = [&deadline]() {
+    return deadline && Clock::now() >= *deadline;
+  };
+
+  std::optional<bool> decision;
+
+  for (int retry = 0; !outOfTime(); ++retry) {
+    if (retry > 0) {
+      // Log the retry attempt; verdicts already in are kept
+      std::cerr << "Timeout occurred. Retrying request inspection for ship "
+                << info.id << "\n";
+
+      // Back off before asking again; late verdicts still count meanwhile
+      Clock::time_point resumeAt = clip(Clock::now() + backoff(retry));
+      decision = co_await collectVotes(ballot, resumeAt);
+      if (decision) {
+        co_return decide(*decision);
+      }
+      if (outOfTime()) {
         break;
       }
     }
 
-    // If all responses are received and at least 2 are valid, return success
-    if (allResponsesReceived) {
-      info.needsInspection = checkCount >= 2;
+    // Query every entity that has not answered yet, in parallel, unless its
+    // breaker says it is shedding load
+    bool asked[ENTITY_COUNT] = {};
+    for (int i = 0; i < ENTITY_COUNT; ++i) {
+      if (!ballot->verdicts[i] && channels[i]->available()) {
+        requestVerdict(*channels[i], ballot, i);
+        asked[i] = true;
+      }
+    }
+
+    Clock::time_point roundStart = Clock::now();
+    Clock::time_point roundEnd =
+        clip(roundStart + utils::scaledSeconds(timeout));
+
+    // An entity still silent past its usual reply latency gets one
+    // duplicate request; whichever copy answers first counts
+    if (policy.hedgeQuantile > 0) {
+      std::pair<Clock::time_point, int> hedges[ENTITY_COUNT];
+      int hedgeCount = 0;
+      for (int i = 0; i < ENTITY_COUNT; ++i) {
+        std::optional<Clock::duration> latency;
+        if (asked[i] && (latency = channels[i]->replyLatency()) &&
+            roundStart + *latency < roundEnd) {
+          hedges[hedgeCount++] = {roundStart + *latency, i};
+        }
+      }
+      std::sort(hedges, hedges + hedgeCount);
+
+      for (int h = 0; h < hedgeCount && !decision; ++h) {
+        decision = co_await collectVotes(ballot, hedges[h].first);
 
-      std::cout << "Ship " << info.id
-                << (info.needsInspection ? " requires" : " does not require")
-                << " inspection\n";
+        int i = hedges[h].second;
+        if (!decision && !ballot->verdicts[i] && channels[i]->available()) {
+          requestVerdict(*channels[i], ballot, i);
+        }
+      }
+    }
 
-      return info.needsInspection;
+    // Stop as soon as two entities agree; the third reply is ignored
+    if (!decision) {
+      decision = co_await collectVotes(ballot, roundEnd);
+    }
+    if (decision) {
+      co_return decide(*decision);
     }
 
-    // Log the retry attempt
-    std::cerr << "Timeout occurred. Retrying request inspection for ship "
-              << info.id << "\n";
+    // Silence for a whole round counts against the entity's breaker
+    for (int i = 0; i < ENTITY_COUNT; ++i) {
+      if (asked[i] && !ballot->verdicts[i]) {
+        channels[i]->reportTimeout();
+      }
+    }
   }
+
+  // Out of budget: whoever has not answered is taken to ask for inspection
+  std::cerr << "Ship " << info.id
+            << " ran out of time; missing verdicts count as CHECK\n";
+  co_return decide(*ballot->decision(true));
 }
 
-bool ShipClient::requestDocking() {
+Task<bool> ShipClient::requestDocking() {
   std::cout << "Ship " << info.id << " starting docking request\n";
 
+  if (!portManagerStream.connect(constants::DEFAULT_PORT_MANAGER)) {
+    std::cerr << "Ship " << info.id << " error: Connection failed\n";
+    co_return false;
+  }
+
   // Send docking request
-  nlohmann::json jsonShip = info.to_json();
-  std::string jsonStr = jsonShip.dump();  // Convert to JSON string
+  char jsonShip[ship_json::MAX_SIZE];
+  size_t length = ship_json::write(info, jsonShip, sizeof(jsonShip));
+  if (length == 0) {
+    std::cerr << "Ship " << info.id << " error: Too large to send\n";
+    co_return false;
+  }
 
-  send(portManagerClientSocket, jsonStr.c_str(), jsonStr.length(), 0);
+  portManagerStream.send(std::string(jsonShip, length));
 
   // Receive response
-  char buffer[1024] = {0};
-  read(portManagerClientSocket, buffer, sizeof(buffer));
+  std::string response;
+  co_await portManagerStream.recv(response);
 
-  bool canDock = std::string(buffer) == constants::RESPONSE_ACCEPTED;
+  bool canDock = response == constants::RESPONSE_ACCEPTED;
 
-  return canDock;
+  co_return canDock;
 }
 
 void ShipClient::doInspection() {
   // Send docking request
-  nlohmann::json jsonShip = info.to_json();
-  std::string jsonStr = jsonShip.dump();  // Convert to JSON string
+  char jsonShip[ship_json::MAX_SIZE];
+  size_t length = ship_json::write(info, jsonShip, sizeof(jsonShip));
+  if (length == 0) {
+    std::cerr << "Ship " << info.id << " error: Too large to send\n";
+    return;
+  }
 
-  send(portManagerClientSocket, jsonStr.c_str(), jsonStr.length(), 0);
+  portManagerStream.send(std::string(jsonShip, length));
 }
 
 }  // namespace ecuafast
@@ -1,23 +1,82 @@
 #pragma once
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "../common/async_stream.hpp"
 #include "../common/constants.hpp"
-#include "../common/socket_wrapper.hpp"
+#include "../common/event_log.hpp"
+#include "../common/event_loop.hpp"
+#include "../common/ship_json.hpp"
+#include "../common/task.hpp"
+#include "../common/transport.hpp"
 #include "../common/types.hpp"
+#include "../common/utils.hpp"
+#include "entity_channel.hpp"
+#include "retry_policy.hpp"
 
 namespace ecuafast {
+// A ship's lifecycle as a coroutine on one client EventLoop. No thread is
+// tied to a ship while it waits, so a single process can keep tens of
+// thousands of them in flight. The client must be created, started and
+// destroyed on the loop's thread.
 class ShipClient {
  public:
-  ShipClient(const ShipInfo& info, int timeout);
-  void start();
-
-  std::string connectToEntity(int port);
+  ShipClient(const ShipInfo& info, int timeout, const RetryPolicy& policy,
+             EntityChannels& entities, Transport& transport, EventLoop& loop);
+  Task<> start();
 
  private:
+  static constexpr int ENTITY_COUNT = 3;
+
+  // Verdicts collected from the three entities, filled in on the ship's
+  // loop. Shared with reply callbacks and wait timers, which may both
+  // outlive the ship.
+  struct Ballot {
+    std::optional<std::string> verdicts[ENTITY_COUNT];
+    int wait = 0;
+    bool timedOut = false;
+    std::coroutine_handle<> waiter;
+
+    // Outcome of the 2-of-3 rule, or nothing while the remaining votes
+    // could still change it. Counting missing votes as CHECK always decides.
+    std::optional<bool> decision(bool missingAsCheck = false) const;
+    void wake();
+  };
+
+  // Resumes on the next verdict or when the current wait times out. Holds
+  // a plain reference: the awaiting frame keeps the ballot alive.
+  class BallotAwaiter {
+   public:
+    explicit BallotAwaiter(Ballot& ballot) : ballot(ballot) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+      ballot.waiter = handle;
+    }
+    void await_resume() const noexcept {}
+
+   private:
+    Ballot& ballot;
+  };
+
   ShipInfo info;
   int timeout;
-  int portManagerClientSocket;
+  RetryPolicy policy;
+  EntityChannels& entities;
+  EventLoop& loop;
+  AsyncStream portManagerStream;
 
-  bool requestInspection();
-  bool requestDocking();
+  void requestVerdict(EntityChannel& entity,
+                      const std::shared_ptr<Ballot>& ballot, int index);
+  // Waits until the ballot is decided or `until` passes
+  Task<std::optional<bool>> collectVotes(std::shared_ptr<Ballot> ballot,
+                                         EventLoop::Clock::time_point until);
+  EventLoop::Clock::duration backoff(int retry);
+  bool decide(bool needsInspection);
+  Task<bool> requestInspection();
+  Task<bool> requestDocking();
   void doInspection();
 };
-}  // namespace ecuafast
\ No newline at end of file
+}  // namespace ecuafast
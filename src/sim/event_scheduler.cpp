@@ -0,0 +1,30 @@
+#include "event_scheduler.hpp"
+
+#include <algorithm>
+
+namespace ecuafast {
+
+void EventScheduler::schedule(double delay, Event event) {
+  scheduleAt(currentTime + std::max(delay, 0.0), std::move(event));
+}
+
+void EventScheduler::scheduleAt(double time, Event event) {
+  events.push({std::max(time, currentTime), nextSeq++, std::move(event)});
+}
+
+size_t EventScheduler::run() {
+  size_t processed = 0;
+
+  while (!events.empty()) {
+    Entry entry = std::move(const_cast<Entry&>(events.top()));
+    events.pop();
+
+    currentTime = entry.time;
+    entry.event();
+    processed++;
+  }
+
+  return processed;
+}
+
+}  // namespace ecuafast
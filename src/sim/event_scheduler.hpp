@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace ecuafast {
+// Virtual clock driven by a priority queue of timestamped events. Time only
+// moves when the next event is popped, so simulated seconds cost nothing.
+// Events with the same timestamp run in the order they were scheduled.
+class EventScheduler {
+ public:
+  using Event = std::function<void()>;
+
+  double now() const { return currentTime; }
+
+  void schedule(double delay, Event event);
+  void scheduleAt(double time, Event event);
+
+  // Runs until no events remain; returns how many were processed
+  size_t run();
+
+ private:
+  struct Entry {
+    double time;
+    uint64_t seq;
+    Event event;
+  };
+
+  struct Later {
+    bool operator()(const Entry& a, const Entry& b) const {
+      return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+    }
+  };
+
+  std::priority_queue<Entry, std::vector<Entry>, Later> events;
+  double currentTime = 0.0;
+  uint64_t nextSeq = 0;
+};
+}  // namespace ecuafast
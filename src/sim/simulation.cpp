@@ -0,0 +1,317 @@
+#include "simulation.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "../common/constants.hpp"
+#include "../common/event_log.hpp"
+#include "../common/utils.hpp"
+
+namespace ecuafast {
+
+namespace {
+// A ship whose entities can never answer within the timeout would retry
+// forever; the threaded version hangs, the simulation gives up instead
+constexpr int MAX_ATTEMPTS = 1000;
+}  // namespace
+
+Simulation::Simulation(const SimulationConfig& config, std::ostream& log)
+    : config(config),
+      log(log),
+      sri(constants::DEFAULT_PORT_SRI, config.averageWindow),
+      senae(constants::DEFAULT_PORT_SENAE, config.quantileMode),
+      supercia(constants::DEFAULT_PORT_SUPERCIA),
+      slots(config.maxSlots, -1),
+      slotSince(config.maxSlots, 0.0) {}
+
+void Simulation::addArrival(double time, const ShipInfo& ship) {
+  auto state = std::make_unique<ShipState>();
+  state->info = ship;
+  state->record.id = ship.id;
+  state->record.arrival = time;
+  state->deadline =
+      config.retry.deadline > 0 ? time + config.retry.deadline : -1.0;
+
+  ShipState* raw = state.get();
+  ships.push_back(std::move(state));
+  scheduler.scheduleAt(time, [this, raw]() { arrive(*raw); });
+}
+
+void Simulation::streamArrivals(std::function<bool(Arrival&)> source) {
+  arrivalSource = std::move(source);
+  pullArrival();
+}
+
+void Simulation::pullArrival() {
+  Arrival arrival;
+  if (!arrivalSource(arrival)) {
+    return;
+  }
+
+  // The next one is read only once this one is due
+  double time = std::max(arrival.time, scheduler.now());
+  scheduler.scheduleAt(time, [this, ship = arrival.ship]() {
+    addArrival(scheduler.now(), ship);
+    pullArrival();
+  });
+}
+
+SimulationReport Simulation::run() {
+  SimulationReport report;
+  report.events = scheduler.run();
+  report.makespan = scheduler.now();
+
+  // Berths still occupied at the end count until the last event
+  for (size_t i = 0; i < slots.size(); ++i) {
+    if (slots[i] >= 0) {
+      busySlotSeconds += report.makespan - slotSince[i];
+    }
+  }
+  report.busySlotSeconds = busySlotSeconds;
+
+  for (auto& ship : ships) {
+    report.ships.push_back(ship->record);
+  }
+  return report;
+}
+
+void Simulation::arrive(ShipState& ship) {
+  eventLog().record(scheduler.now(), ship.info.id, "arrived");
+
+  if (config.verbose) {
+    logAt() << "Ship " << ship.info.id << " starting inspection request\n";
+    logAt() << "Ship " << ship.info.id << " starting docking request\n";
+  }
+
+  requestDocking(ship);
+  requestInspection(ship);
+}
+
+void Simulation::requestDocking(ShipState& ship) {
+  bool available = std::find(slots.begin(), slots.end(), -1) != slots.end();
+
+  if (!available) {
+    ship.record.rejected = true;
+    eventLog().record(scheduler.now(), ship.info.id, "rejected");
+    return;
+  }
+
+  ship.canDock = true;
+
+  if (random::uniform(random::Draw::DAMAGE, ship.info.id) <
+      config.damageProb) {
+    // Same as PortManager::handleDamageEvent: the first occupied berth is
+    // cleared and the damaged ship never docks
+    auto occupied = std::find_if(slots.begin(), slots.end(),
+                                 [](int shipId) { return shipId >= 0; });
+    if (occupied != slots.end()) {
+      releaseSlot(occupied - slots.begin());
+    }
+
+    ship.record.damaged = true;
+    eventLog().record(scheduler.now(), ship.info.id, "damaged");
+    if (config.verbose) {
+      logAt() << "Ship " << ship.info.id << " is broken and was removed\n";
+    }
+  }
+}
+
+void Simulation::requestInspection(ShipState& ship) {
+  ship.record.attempts++;
+
+  // Only entities that have not voted are asked again. A reply still in
+  // flight from an earlier round stays valid; whichever answer lands first
+  // counts, exactly like ShipClient does.
+  double sentAt = scheduler.now();
+  EntityServer* entities[] = {&sri, &senae, &supercia};
+  for (size_t i = 0; i < ship.votes.size(); ++i) {
+    Vote& vote = ship.votes[i];
+    if (vote.cast) {
+      continue;
+    }
+
+    std::string response = entities[i]->evaluateShip(ship.info);
+    double replyAt =
+        sentAt + random::uniformInt(random::Draw::DELAY, ship.info.id, 1, 5,
+                                    entities[i]->getPort());
+    if (vote.replyAt < 0 || replyAt < vote.replyAt) {
+      vote.replyAt = replyAt;
+      vote.replyCheck = response == constants::RESPONSE_CHECK;
+    }
+  }
+
+  double roundEnd = withinBudget(ship, sentAt + config.timeout);
+  if (collectVotes(ship, roundEnd)) {
+    return;
+  }
+
+  // No quorum this round. The ship backs off before asking again, but a
+  // late reply landing meanwhile can still settle the vote.
+  double pause = config.retry.backoff(
+      ship.record.attempts,
+      random::uniform(random::Draw::BACKOFF, ship.info.id));
+  double retryAt = withinBudget(ship, roundEnd + pause);
+
+  // Once the budget is spent there is no retry to announce
+  if (config.verbose && (ship.deadline < 0 || roundEnd < ship.deadline)) {
+    scheduler.scheduleAt(roundEnd, [this, &ship]() {
+      logAt() << "Timeout occurred. Retrying request inspection for ship "
+              << ship.info.id << "\n";
+    });
+  }
+
+  if (collectVotes(ship, retryAt)) {
+    return;
+  }
+
+  scheduler.scheduleAt(retryAt, [this, &ship]() {
+    if (ship.deadline >= 0 && scheduler.now() >= ship.deadline) {
+      // Whoever has not answered is taken to ask for inspection
+      int passes = 0;
+      for (const Vote& vote : ship.votes) {
+        passes += vote.cast && !vote.check;
+      }
+      if (config.verbose) {
+        logAt() << "Ship " << ship.info.id
+                << " ran out of time; missing verdicts count as CHECK\n";
+      }
+      decide(ship, passes < 2);
+      return;
+    }
+    if (ship.record.attempts >= MAX_ATTEMPTS) {
+      if (config.verbose) {
+        logAt() << "Ship " << ship.info.id << " gave up after "
+                << ship.record.attempts << " attempts\n";
+      }
+      return;
+    }
+    requestInspection(ship);
+  });
+}
+
+bool Simulation::collectVotes(ShipState& ship, double until) {
+  // Replies that land before `until`, in arrival order
+  // At most three, so each is inserted in place as it is found
+  std::array<Vote*, 3> arrivals{};
+  size_t arrived = 0;
+  for (Vote& vote : ship.votes) {
+    if (!vote.cast && vote.replyAt >= 0 && vote.replyAt < until) {
+      size_t i = arrived++;
+      for (; i > 0 && arrivals[i - 1]->replyAt > vote.replyAt; --i) {
+        arrivals[i] = arrivals[i - 1];
+      }
+      arrivals[i] = &vote;
+    }
+  }
+
+  // The decision is taken as soon as two entities agree
+  for (size_t i = 0; i < arrived; ++i) {
+    Vote& vote = *arrivals[i];
+    double votedAt = vote.replyAt;
+    vote.cast = true;
+    vote.check = vote.replyCheck;
+    vote.replyAt = -1.0;
+
+    int checks = 0;
+    int passes = 0;
+    for (const Vote& other : ship.votes) {
+      if (other.cast) {
+        (other.check ? checks : passes)++;
+      }
+    }
+
+    if (checks >= 2 || passes >= 2) {
+      bool needsInspection = checks >= 2;
+      scheduler.scheduleAt(votedAt, [this, &ship, needsInspection]() {
+        decide(ship, needsInspection);
+      });
+      return true;
+    }
+  }
+  return false;
+}
+
+double Simulation::withinBudget(const ShipState& ship, double time) const {
+  return ship.deadline >= 0 ? std::min(time, ship.deadline) : time;
+}
+
+void Simulation::decide(ShipState& ship, bool needsInspection) {
+  ship.info.needsInspection = needsInspection;
+  ship.record.needsInspection = needsInspection;
+  ship.record.decided = scheduler.now();
+  eventLog().record(scheduler.now(), ship.info.id,
+                    needsInspection ? "check" : "pass");
+
+  if (config.verbose) {
+    logAt() << "Ship " << ship.info.id
+            << (needsInspection ? " requires" : " does not require")
+            << " inspection\n";
+  }
+
+  if (needsInspection && ship.canDock && !ship.record.damaged) {
+    dock(ship);
+  }
+}
+
+void Simulation::dock(ShipState& ship) {
+  if (config.verbose) {
+    logAt() << "Ship " << ship.info.id << " starting inspection\n";
+  }
+
+  auto slot = std::find(slots.begin(), slots.end(), -1);
+  if (slot == slots.end()) {
+    return;  // PortManager::doInspection drops the ship as well
+  }
+  *slot = ship.info.id;
+  slotSince[slot - slots.begin()] = scheduler.now();
+
+  int processTime = config.unloadTime;
+  if (ship.info.destination != "Ecuador") {
+    processTime /= 2;
+  }
+  if (ship.info.needsInspection) {
+    processTime *= 2;
+  }
+
+  ship.record.unloadStart = scheduler.now();
+  eventLog().record(scheduler.now(), ship.info.id, "unloading");
+  if (config.verbose) {
+    logAt() << "Ship " << ship.info.id << " starting unload process ("
+            << processTime << " seconds)\n";
+  }
+
+  scheduler.schedule(processTime, [this, &ship]() { finishUnload(ship); });
+}
+
+void Simulation::finishUnload(ShipState& ship) {
+  // A damage event cleared the berth mid-unload: like a cancelled timer in
+  // PortManager::clearSlot, the ship never departs
+  auto slot = std::find(slots.begin(), slots.end(), ship.info.id);
+  if (slot == slots.end()) {
+    return;
+  }
+
+  ship.record.departure = scheduler.now();
+  eventLog().record(scheduler.now(), ship.info.id, "departed");
+
+  if (config.verbose) {
+    logAt() << "Ship " << ship.info.id << " finished unloading\n";
+  }
+
+  releaseSlot(slot - slots.begin());
+  if (config.verbose) {
+    logAt() << "Releasing slot for ship " << ship.info.id << "\n";
+  }
+}
+
+void Simulation::releaseSlot(size_t index) {
+  busySlotSeconds += scheduler.now() - slotSince[index];
+  slots[index] = -1;
+}
+
+std::ostream& Simulation::logAt() {
+  return log << "[" << std::fixed << std::setprecision(0) << std::setw(6)
+             << scheduler.now() << "s] ";
+}
+
+}  // namespace ecuafast
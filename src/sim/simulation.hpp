@@ -0,0 +1,111 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "../common/arrival_trace.hpp"
+#include "../common/quantile.hpp"
+#include "../common/types.hpp"
+#include "../entities/senae_server.hpp"
+#include "../entities/sri_server.hpp"
+#include "../entities/supercia_server.hpp"
+#include "../ship/retry_policy.hpp"
+#include "event_scheduler.hpp"
+
+namespace ecuafast {
+struct SimulationConfig {
+  int timeout = 4;
+  int unloadTime = 5;
+  int maxSlots = 5;
+  double damageProb = 0.2;
+  size_t averageWindow = 20;
+  QuantileMode quantileMode = QuantileMode::EXACT;
+  RetryPolicy retry;  // hedging is not modelled
+  bool verbose = true;
+};
+
+// What happened to one ship, in virtual seconds since the start of the run.
+// Times stay negative for stages the ship never reached.
+struct ShipRecord {
+  int id = 0;
+  double arrival = 0.0;
+  double decided = -1.0;
+  double unloadStart = -1.0;
+  double departure = -1.0;
+  int attempts = 0;
+  bool needsInspection = false;
+  bool rejected = false;
+  bool damaged = false;
+};
+
+struct SimulationReport {
+  std::vector<ShipRecord> ships;
+  double makespan = 0.0;
+  double busySlotSeconds = 0.0;
+  size_t events = 0;
+};
+
+// Discrete-event model of a full run. Ships, the three control entities and
+// the port manager all schedule against one virtual clock instead of
+// sleeping, and decisions reuse the real entities' evaluateShip(), so a run
+// reaches the same verdicts and unload times as the networked version.
+class Simulation {
+ public:
+  Simulation(const SimulationConfig& config, std::ostream& log);
+
+  void addArrival(double time, const ShipInfo& ship);
+  // Pulls arrivals one at a time as the clock reaches them, so a long trace
+  // is never held in memory as pending events. Exceptions from `source`
+  // come out of run().
+  void streamArrivals(std::function<bool(Arrival&)> source);
+  SimulationReport run();
+
+ private:
+  // One entity's part in a ship's 2-of-3 vote
+  struct Vote {
+    double replyAt = -1.0;  // earliest reply still in flight, -1 if none
+    bool replyCheck = false;
+    bool cast = false;
+    bool check = false;
+  };
+
+  struct ShipState {
+    ShipInfo info;
+    ShipRecord record;
+    std::array<Vote, 3> votes;
+    double deadline = -1.0;  // inspection budget runs out, -1 if unbounded
+    bool canDock = false;
+    bool decided = false;
+  };
+
+  SimulationConfig config;
+  std::ostream& log;
+  EventScheduler scheduler;
+
+  SRIServer sri;
+  SENAEServer senae;
+  SuperCIAServer supercia;
+
+  std::vector<std::unique_ptr<ShipState>> ships;
+  std::function<bool(Arrival&)> arrivalSource;
+  std::vector<int> slots;  // ship id per berth, -1 when free
+  std::vector<double> slotSince;
+  double busySlotSeconds = 0.0;
+
+  void pullArrival();
+  void arrive(ShipState& ship);
+  void requestDocking(ShipState& ship);
+  void requestInspection(ShipState& ship);
+  // Casts votes whose replies land before `until`; true once decided
+  bool collectVotes(ShipState& ship, double until);
+  void decide(ShipState& ship, bool needsInspection);
+  double withinBudget(const ShipState& ship, double time) const;
+  void dock(ShipState& ship);
+  void finishUnload(ShipState& ship);
+  void releaseSlot(size_t index);
+
+  std::ostream& logAt();
+};
+}  // namespace ecuafast
@@ -0,0 +1,212 @@
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "../common/random.hpp"
+#include "../common/thread_pool.hpp"
+#include "../common/utils.hpp"
+
+namespace ecuafast {
+
+namespace {
+// What one run leaves behind for the aggregation
+struct RunResult {
+  double makespan = 0.0;
+  double busySlotSeconds = 0.0;
+  size_t unloaded = 0;
+  std::vector<double> waits;
+};
+
+template <typename T>
+std::vector<T> parseValues(const std::string& list) {
+  std::vector<T> values;
+  std::istringstream in(list);
+  std::string item;
+  while (std::getline(in, item, ',')) {
+    std::istringstream value(item);
+    T parsed;
+    if (!(value >> parsed) || !value.eof()) {
+      throw std::invalid_argument("Bad sweep value: " + item);
+    }
+    values.push_back(parsed);
+  }
+  if (values.empty()) {
+    throw std::invalid_argument("Empty sweep list: " + list);
+  }
+  return values;
+}
+
+RunResult runOnce(SimulationConfig config, int shipCount, uint64_t seed) {
+  config.verbose = false;
+  random::Scope scope(seed);
+
+  std::ostream discard(nullptr);
+  Simulation simulation(config, discard);
+  for (int i = 0; i < shipCount; ++i) {
+    simulation.addArrival(0.0, utils::generateRandomShip(i));
+  }
+  SimulationReport report = simulation.run();
+
+  RunResult result;
+  result.makespan = report.makespan;
+  result.busySlotSeconds = report.busySlotSeconds;
+  for (const ShipRecord& ship : report.ships) {
+    if (ship.unloadStart >= 0) {
+      result.waits.push_back(ship.unloadStart - ship.arrival);
+    }
+    result.unloaded += ship.departure >= 0;
+  }
+  return result;
+}
+
+// Every value of an axis must satisfy `valid`
+template <typename T, typename Valid>
+void checkValues(const std::vector<T>& values, const char* axis,
+                 Valid valid) {
+  for (const T& value : values) {
+    if (!valid(value)) {
+      std::ostringstream message;
+      message << "Sweep value out of range for " << axis << ": " << value;
+      throw std::invalid_argument(message.str());
+    }
+  }
+}
+}  // namespace
+
+SweepGrid SweepGrid::parse(const std::string& spec,
+                           const SimulationConfig& base) {
+  SweepGrid grid;
+  grid.maxSlots = {base.maxSlots};
+  grid.unloadTimes = {base.unloadTime};
+  grid.damageProbs = {base.damageProb};
+  grid.timeouts = {base.timeout};
+
+  std::istringstream in(spec);
+  std::string axis;
+  while (std::getline(in, axis, ';')) {
+    if (axis.size() < 3 || axis[1] != '=') {
+      throw std::invalid_argument("Bad sweep axis: " + axis);
+    }
+    std::string list = axis.substr(2);
+    switch (axis[0]) {
+      case 'n':
+        grid.maxSlots = parseValues<int>(list);
+        break;
+      case 'y':
+        grid.unloadTimes = parseValues<int>(list);
+        break;
+      case 'p':
+        grid.damageProbs = parseValues<double>(list);
+        break;
+      case 'x':
+        grid.timeouts = parseValues<int>(list);
+        break;
+      default:
+        throw std::invalid_argument("Unknown sweep parameter: " + axis);
+    }
+  }
+
+  // Checked after parsing, so values carried over from `base` count too
+  auto positive = [](int value) { return value > 0; };
+  checkValues(grid.maxSlots, "n", positive);
+  checkValues(grid.unloadTimes, "y", positive);
+  checkValues(grid.timeouts, "x", positive);
+  checkValues(grid.damageProbs, "p",
+              [](double value) { return value >= 0.0 && value <= 1.0; });
+  return grid;
+}
+
+std::vector<SweepPoint> SweepGrid::points() const {
+  std::vector<SweepPoint> points;
+  for (int slots : maxSlots) {
+    for (int unload : unloadTimes) {
+      for (double damage : damageProbs) {
+        for (int timeout : timeouts) {
+          points.push_back({slots, unload, damage, timeout});
+        }
+      }
+    }
+  }
+  return points;
+}
+
+std::vector<SweepRow> runSweep(const SimulationConfig& base,
+                               const SweepGrid& grid, int shipCount,
+                               int replicas, int threads, uint64_t seed) {
+  std::vector<SweepPoint> points = grid.points();
+  replicas = std::max(replicas, 1);
+  size_t runs = points.size() * replicas;
+
+  // Each task writes only its own slot
+  std::vector<RunResult> results(runs);
+  {
+    ThreadPool pool(std::max(threads, 1), runs, RejectPolicy::BLOCK);
+    for (size_t run = 0; run < runs; ++run) {
+      const SweepPoint& point = points[run / replicas];
+      SimulationConfig config = base;
+      config.maxSlots = point.maxSlots;
+      config.unloadTime = point.unloadTime;
+      config.damageProb = point.damageProb;
+      config.timeout = point.timeout;
+      uint64_t runSeed = Random(seed, run % replicas)();
+
+      pool.submit([&results, run, config, shipCount, runSeed]() {
+        results[run] = runOnce(config, shipCount, runSeed);
+      });
+    }
+    pool.shutdown();
+  }
+
+  std::vector<SweepRow> rows;
+  for (size_t p = 0; p < points.size(); ++p) {
+    SweepRow row;
+    row.point = points[p];
+    row.replicas = replicas;
+
+    std::vector<double> waits;
+    for (int r = 0; r < replicas; ++r) {
+      const RunResult& result = results[p * replicas + r];
+      if (result.makespan > 0) {
+        row.throughput += result.unloaded * 3600.0 / result.makespan;
+        row.utilization += result.busySlotSeconds /
+                           (row.point.maxSlots * result.makespan);
+      }
+      row.unloaded += result.unloaded;
+      waits.insert(waits.end(), result.waits.begin(), result.waits.end());
+    }
+    row.throughput /= replicas;
+    row.utilization /= replicas;
+
+    std::sort(waits.begin(), waits.end());
+    row.waitP50 = utils::percentile(waits, 0.50);
+    row.waitP95 = utils::percentile(waits, 0.95);
+    row.waitP99 = utils::percentile(waits, 0.99);
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+void printSweep(std::ostream& out, const std::vector<SweepRow>& rows) {
+  out << std::setw(6) << "slots" << std::setw(8) << "unload" << std::setw(8)
+      << "damage" << std::setw(9) << "timeout" << std::setw(6) << "runs"
+      << std::setw(10) << "ships/h" << std::setw(7) << "util"
+      << std::setw(10) << "unloaded" << std::setw(9) << "wait50"
+      << std::setw(9) << "wait95" << std::setw(9) << "wait99" << "\n";
+
+  for (const SweepRow& row : rows) {
+    out << std::fixed << std::setprecision(2) << std::setw(6)
+        << row.point.maxSlots << std::setw(8) << row.point.unloadTime
+        << std::setw(8) << row.point.damageProb << std::setw(9)
+        << row.point.timeout << std::setw(6) << row.replicas
+        << std::setprecision(1) << std::setw(10) << row.throughput
+        << std::setprecision(3) << std::setw(7) << row.utilization
+        << std::setw(10) << row.unloaded << std::setprecision(1)
+        << std::setw(9) << row.waitP50 << std::setw(9) << row.waitP95
+        << std::setw(9) << row.waitP99 << "\n";
+  }
+}
+
+}  // namespace ecuafast
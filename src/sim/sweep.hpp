@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "simulation.hpp"
+
+namespace ecuafast {
+// One combination of the swept parameters
+struct SweepPoint {
+  int maxSlots = 0;
+  int unloadTime = 0;
+  double damageProb = 0.0;
+  int timeout = 0;
+};
+
+// Values to try for each parameter; the sweep covers every combination
+struct SweepGrid {
+  std::vector<int> maxSlots;
+  std::vector<int> unloadTimes;
+  std::vector<double> damageProbs;
+  std::vector<int> timeouts;
+
+  // "n=5,10,20;y=5,10;p=0.1,0.2;x=4" using the command-line letters.
+  // Parameters left out keep their value from `base`. Throws
+  // std::invalid_argument on anything else.
+  static SweepGrid parse(const std::string& spec,
+                         const SimulationConfig& base);
+
+  std::vector<SweepPoint> points() const;
+};
+
+// Results for one point, over all of its replicas. Wait is the time from
+// arrival to the start of unloading, for ships that got that far.
+struct SweepRow {
+  SweepPoint point;
+  int replicas = 0;
+  double throughput = 0.0;   // ships unloaded per simulated hour
+  double utilization = 0.0;  // share of berth time spent occupied
+  size_t unloaded = 0;
+  double waitP50 = 0.0;
+  double waitP95 = 0.0;
+  double waitP99 = 0.0;
+};
+
+// Runs `replicas` simulations of `shipCount` ships for every point of the
+// grid, spread over `threads` threads. Each run owns its simulation and its
+// random streams, so runs share nothing while they execute. Replica r uses
+// the same seed at every point, so points are compared on the same ships
+// and the same luck.
+std::vector<SweepRow> runSweep(const SimulationConfig& base,
+                               const SweepGrid& grid, int shipCount,
+                               int replicas, int threads, uint64_t seed);
+
+void printSweep(std::ostream& out, const std::vector<SweepRow>& rows);
+}  // namespace ecuafast
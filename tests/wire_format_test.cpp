@@ -0,0 +1,33 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/wire_format.hpp"
+
+namespace {
+int failures = 0;
+
+// A batch of no ships is malformed: the entity server could not key its
+// reply delay by any ship
+void expectRejected(const char* name, const std::string& message) {
+  uint64_t requestId;
+  std::vector<ecuafast::ShipInfo> ships;
+  try {
+    ecuafast::wire::decodeBatchRequest(message, requestId, ships);
+  } catch (const std::exception&) {
+    return;
+  }
+  std::cerr << name << ": empty batch accepted\n";
+  failures++;
+}
+}  // namespace
+
+int main() {
+  std::vector<ecuafast::ShipInfo> none;
+  expectRejected("binary", ecuafast::wire::encodeBatchRequest(
+                               ecuafast::WireFormat::BINARY, 1, none));
+  expectRejected("json", ecuafast::wire::encodeBatchRequest(
+                             ecuafast::WireFormat::JSON, 1, none));
+  expectRejected("json literal", R"({"batch":1,"ships":[]})");
+  return failures == 0 ? 0 : 1;
+}